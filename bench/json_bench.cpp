@@ -0,0 +1,309 @@
+// 解析/序列化吞吐量基准
+// 用法: json_bench [corpus_dir] [min_seconds]
+// corpus_dir 中按文件名查找标准语料(twitter.json, citm_catalog.json, canada.json, gsoc-2018.json, logs.ndjson),
+// 缺失的语料用结构相近的合成数据代替, 结果表中会标注为 synthetic
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+
+#include "json.hpp"
+
+namespace {
+    // 全局 operator new 的调用次数, 用来统计每个文档的分配次数
+    std::atomic<size_t> allocation_count{0};
+
+    auto counted_alloc(size_t size) -> void* {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        if (auto ptr = std::malloc(size == 0 ? 1 : size)) {
+            return ptr;
+        }
+        throw std::bad_alloc{};
+    }
+    auto counted_aligned_alloc(size_t size, std::align_val_t align) -> void* {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        const auto alignment = static_cast<size_t>(align);
+        if (auto ptr = std::aligned_alloc(alignment, (std::max<size_t>(size, 1) + alignment - 1) / alignment * alignment)) {
+            return ptr;
+        }
+        throw std::bad_alloc{};
+    }
+}
+
+auto operator new(size_t size) -> void* { return counted_alloc(size); }
+auto operator new[](size_t size) -> void* { return counted_alloc(size); }
+auto operator new(size_t size, std::align_val_t align) -> void* { return counted_aligned_alloc(size, align); }
+auto operator new[](size_t size, std::align_val_t align) -> void* { return counted_aligned_alloc(size, align); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+namespace {
+    struct Corpus {
+        std::string name;
+        std::string text;
+        bool lines = false;      // NDJSON, 每行一个文档
+        bool synthetic = false;
+    };
+
+    // 一次基准的结果, 按一次迭代处理整个语料计
+    struct Measurement {
+        size_t iterations = 0;
+        double seconds = 0;
+        size_t allocations = 0;
+    };
+
+    template<typename Fn>
+    auto measure(Fn&& fn, double min_seconds) -> Measurement {
+        fn();  // 预热, 同时让惰性初始化(如扫描内核的选择)不计入结果
+        Measurement result;
+        const auto allocations_before = allocation_count.load();
+        const auto start = std::chrono::steady_clock::now();
+        do {
+            fn();
+            ++result.iterations;
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (result.seconds < min_seconds);
+        result.allocations = allocation_count.load() - allocations_before;
+        return result;
+    }
+
+    // 防止编译器把基准中的计算整个优化掉
+    template<typename T>
+    void keep(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    void report(const std::string& benchmark, const Corpus& corpus, size_t documents, const Measurement& m) {
+        const auto per_iteration = m.seconds / static_cast<double>(m.iterations);
+        const auto mb_per_s = static_cast<double>(corpus.text.size()) / per_iteration / 1e6;
+        const auto docs_per_s = static_cast<double>(documents) / per_iteration;
+        const auto allocs_per_doc = static_cast<double>(m.allocations) / static_cast<double>(m.iterations * documents);
+        char line[256];
+        std::snprintf(line, sizeof line, "%-22s %-26s %10.1f %14.0f %14.1f", benchmark.c_str(),
+                      (corpus.name + (corpus.synthetic ? " (synthetic)" : "")).c_str(), mb_per_s, docs_per_s, allocs_per_doc);
+        std::cout << line << '\n';
+    }
+
+    auto read_file(const std::filesystem::path& path) -> std::optional<std::string> {
+        std::ifstream in{path, std::ios::binary};
+        if (!in) {
+            return {};
+        }
+        std::ostringstream content;
+        content << in.rdbuf();
+        return content.str();
+    }
+
+    // 以下合成语料模仿对应标准语料的结构: 字符串密集、对象密集、浮点数组密集、纯字符串对象与日志行
+    auto synthetic_twitter(std::mt19937& rng) -> std::string {
+        std::string out = R"({"statuses":[)";
+        for (int i = 0; i < 4000; ++i) {
+            if (i) out += ',';
+            out += R"({"created_at":"Sun Aug 31 00:29:15 +0000 2014","id":)" + std::to_string(505874924095815681LL + i) +
+                   R"(,"text":"@aym0566x \u540d\u524d:\u524d\u7530\u3042\u3086\u307f \"quoted\" line\nbreak #)" + std::to_string(rng() % 1000) +
+                   R"(","truncated":false,"user":{"id":)" + std::to_string(rng()) +
+                   R"(,"name":"user name","screen_name":"screen_)" + std::to_string(i) +
+                   R"(","followers_count":)" + std::to_string(rng() % 100000) +
+                   R"(,"verified":false,"profile_image_url":"http:\/\/pbs.twimg.com\/profile_images\/)" + std::to_string(rng()) +
+                   R"(.jpeg"},"entities":{"hashtags":[],"urls":[],"user_mentions":[{"screen_name":"aym0566x","indices":[0,9]}]},"retweet_count":)" +
+                   std::to_string(rng() % 100) + R"(,"favorited":false,"lang":"ja","geo":null})";
+        }
+        return out + R"(],"search_metadata":{"completed_in":0.087,"count":100}})";
+    }
+    auto synthetic_citm(std::mt19937& rng) -> std::string {
+        std::string out = R"({"areaNames":{)";
+        for (int i = 0; i < 2000; ++i) {
+            if (i) out += ',';
+            out += '"' + std::to_string(205705993 + i) + R"(":"Area )" + std::to_string(i) + '"';
+        }
+        out += R"(},"performances":[)";
+        for (int i = 0; i < 6000; ++i) {
+            if (i) out += ',';
+            out += R"({"eventId":)" + std::to_string(138586341 + i % 200) + R"(,"id":)" + std::to_string(339887544 + i) +
+                   R"(,"logo":null,"name":null,"prices":[{"amount":)" + std::to_string(rng() % 100000) +
+                   R"(,"audienceSubCategoryId":337100890,"seatCategoryId":338937295}],"seatCategories":[{"areas":[{"areaId":205705999,"blockIds":[]},{"areaId":205705998,"blockIds":[]}],"seatCategoryId":338937295}],"start":)" +
+                   std::to_string(1372354200000LL + i) + R"(,"venueCode":"PLEYEL_PLEYEL"})";
+        }
+        return out + "]}";
+    }
+    auto synthetic_canada(std::mt19937& rng) -> std::string {
+        std::uniform_real_distribution<double> lon{-141.0, -52.0}, lat{41.0, 83.0};
+        std::string out = R"({"type":"FeatureCollection","features":[{"type":"Feature","geometry":{"type":"Polygon","coordinates":[)";
+        char buffer[64];
+        for (int ring = 0; ring < 60; ++ring) {
+            if (ring) out += ',';
+            out += '[';
+            for (int i = 0; i < 1900; ++i) {
+                if (i) out += ',';
+                std::snprintf(buffer, sizeof buffer, "[%.15g,%.15g]", lon(rng), lat(rng));
+                out += buffer;
+            }
+            out += ']';
+        }
+        return out + "]}}]}";
+    }
+    auto synthetic_gsoc(std::mt19937& rng) -> std::string {
+        std::string out = "{";
+        for (int i = 0; i < 3000; ++i) {
+            if (i) out += ',';
+            out += '"' + std::to_string(i + 1) + R"(":{"@context":"http://schema.org","@type":"SoftwareSourceCode","name":"Project )" +
+                   std::to_string(i) + R"(","description":"A reasonably long description of the project that mostly consists of plain prose and is typical for this corpus )" +
+                   std::to_string(rng()) + R"(","sponsor":{"@type":"Organization","name":"Org )" + std::to_string(rng() % 200) +
+                   R"(","disambiguatingDescription":"Short text","url":"https://example.org"},"author":{"@type":"Person","name":"Student )" +
+                   std::to_string(i) + R"("}})";
+        }
+        return out + "}";
+    }
+    auto synthetic_logs(std::mt19937& rng) -> std::string {
+        std::string out;
+        for (int i = 0; i < 40000; ++i) {
+            out += R"({"ts":)" + std::to_string(1700000000000LL + i) + R"(,"level":")" + (rng() % 10 ? "info" : "error") +
+                   R"(","service":"api","latency_ms":)" + std::to_string(static_cast<double>(rng() % 100000) / 100.0) +
+                   R"(,"path":"/v1/items/)" + std::to_string(rng() % 5000) + R"(","status":200,"user":{"id":)" + std::to_string(rng()) +
+                   R"(,"region":"eu-west-1"},"tags":["a","b"]})" + "\n";
+        }
+        return out;
+    }
+
+    auto load_corpora(const std::filesystem::path& dir) -> std::vector<Corpus> {
+        std::mt19937 rng{42};
+        struct Source {
+            const char* file;
+            bool lines;
+            std::string (*generate)(std::mt19937&);
+        };
+        const Source sources[] = {
+            {"twitter.json", false, synthetic_twitter},
+            {"citm_catalog.json", false, synthetic_citm},
+            {"canada.json", false, synthetic_canada},
+            {"gsoc-2018.json", false, synthetic_gsoc},
+            {"logs.ndjson", true, synthetic_logs},
+        };
+        std::vector<Corpus> corpora;
+        for (const auto& source : sources) {
+            Corpus corpus{source.file, {}, source.lines, false};
+            if (auto text = read_file(dir / source.file)) {
+                corpus.text = std::move(*text);
+            } else {
+                corpus.text = source.generate(rng);
+                corpus.synthetic = true;
+            }
+            corpora.push_back(std::move(corpus));
+        }
+        return corpora;
+    }
+
+    // 对每个对象的每个键各查找一次, 返回查找次数
+    auto lookup_all(const json::Node& node) -> size_t {
+        size_t lookups = 0;
+        if (auto object = node.get_if<json::ObjectNode>()) {
+            for (const auto& [key, value] : *object) {
+                keep(node.find(key.view()));
+                lookups += 1 + lookup_all(value);
+            }
+        } else if (auto array = node.get_if<json::ArrayNode>()) {
+            for (const auto& element : *array) {
+                lookups += lookup_all(element);
+            }
+        }
+        return lookups;
+    }
+
+    void run_document(const Corpus& corpus, double min_seconds) {
+        const auto& text = corpus.text;
+        report("Node::from_str", corpus, 1, measure([&] { keep(json::Node::from_str(text)); }, min_seconds));
+        report("Document::parse", corpus, 1, measure([&] { keep(json::Document::parse(text)); }, min_seconds));
+        report("Parser packed arrays", corpus, 1, measure([&] {
+            json::JsonParser::Parser parser{text};
+            parser.set_pack_threshold(16);
+            keep(parser.parse());
+        }, min_seconds));
+        // 长期持有、经 reset 复用的解析器: 预热后 arena 的普通块与解析器的缓冲区都已长到位,
+        // 剩下的分配来自逐步扩容的宽数组的中间缓冲区(见 JsonMemory::Arena)
+        json::JsonParser::Parser reused;
+        report("Parser reused", corpus, 1, measure([&] {
+            reused.reset(text);
+            keep(reused.parse());
+        }, min_seconds));
+        report("Tape::parse", corpus, 1, measure([&] { keep(json::JsonTape::Tape::parse(text)); }, min_seconds));
+        report("validate", corpus, 1, measure([&] { keep(json::validate(text)); }, min_seconds));
+        // 冷启动: 映射缓存的二进制镜像, 只做结构检查
+        const auto image_path = std::filesystem::temp_directory_path() / ("json_bench_" + corpus.name + ".tape");
+        if (json::JsonTape::Tape::parse(text)->save(image_path)) {
+            report("Image::open", corpus, 1, measure([&] { keep(json::JsonTape::Image::open(image_path)); }, min_seconds));
+            std::filesystem::remove(image_path);
+        }
+
+        const auto node = *json::Node::from_str(text);
+        report("Node::to_str", corpus, 1, measure([&] { keep(node.to_str()); }, min_seconds));
+        report("Node::find (all keys)", corpus, 1, measure([&] { keep(lookup_all(node)); }, min_seconds));
+        report("on-demand top fields", corpus, 1, measure([&] {
+            const auto root = json::JsonOnDemand::Value::from_str(text);
+            for (const auto field : root->fields()) {
+                keep(field.second.type());
+            }
+        }, min_seconds));
+    }
+
+    void run_lines(const Corpus& corpus, double min_seconds) {
+        size_t records = 0;
+        json::JsonLines::for_each_line(corpus.text, [&](std::string_view) { ++records; });
+        report("Node::from_str/line", corpus, records, measure([&] {
+            json::JsonLines::for_each_line(corpus.text, [](std::string_view line) { keep(json::Node::from_str(line)); });
+        }, min_seconds));
+        json::JsonParser::Parser reused;
+        report("Parser reused/line", corpus, records, measure([&] {
+            json::JsonLines::for_each_line(corpus.text, [&](std::string_view line) {
+                reused.reset(line);
+                keep(reused.parse());
+            });
+        }, min_seconds));
+        report("JsonLines::parse", corpus, records, measure([&] {
+            keep(json::JsonLines::parse(corpus.text, {.threads = 1}));
+        }, min_seconds));
+        report("JsonLines interned", corpus, records, measure([&] {
+            keep(json::JsonLines::parse(corpus.text, {.threads = 1, .intern_keys = true}));
+        }, min_seconds));
+        const auto batch = json::JsonLines::parse(corpus.text, {.threads = 1});
+        report("Node::to_str/line", corpus, records, measure([&] {
+            for (const auto& record : batch.records) {
+                keep(record->to_str());
+            }
+        }, min_seconds));
+        report("Node::find/line", corpus, records, measure([&] {
+            for (const auto& record : batch.records) {
+                keep(lookup_all(*record));
+            }
+        }, min_seconds));
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::filesystem::path dir = argc > 1 ? argv[1] : "data";
+    const double min_seconds = argc > 2 ? std::atof(argv[2]) : 0.5;
+
+    const auto corpora = load_corpora(dir);
+    std::cout << "scan kernels: " << json::JsonScan::kernels().name << '\n';
+    char header[256];
+    std::snprintf(header, sizeof header, "%-22s %-26s %10s %14s %14s", "benchmark", "corpus", "MB/s", "docs/s", "allocs/doc");
+    std::cout << header << '\n';
+    for (const auto& corpus : corpora) {
+        if (corpus.lines) {
+            run_lines(corpus, min_seconds);
+        } else {
+            run_document(corpus, min_seconds);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,215 @@
+// libFuzzer 入口: 用各种解析方式处理同一份输入, 并检查它们的结论一致
+// 覆盖 Parser(宽松/严格/紧凑数组)、parse_sax、parse_into、并行与增量解析、磁带及其二进制镜像、按需游标与按行解析
+// 输入被复制到恰好等长的堆缓冲区, 越过 json_str 末尾的读取会被 AddressSanitizer 立即发现
+// 用法: json_fuzz [corpus_dir] [-max_len=N ...]
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "json.hpp"
+
+namespace {
+    // 检查失败时中止, 让 libFuzzer 保存触发输入
+    void check(bool condition) {
+        if (!condition) {
+            std::abort();
+        }
+    }
+
+    // parse_into 的目标: 覆盖绑定成员的各种类型, 其余的键被跳过
+    struct FuzzRecord {
+        int64_t id = 0;
+        std::string name;
+        std::vector<double> values;
+        std::optional<bool> flag;
+        json::Node extra;
+    };
+
+    // 沿按需解析的游标访问整个值(find/elements/fields/raw/at); expected 非空时输入是合法的, 逐项与节点对照
+    // 每次 raw 与 find 都要跳过子树, 所以最多访问 max_values 个值, 避免嵌套很深的输入耗时平方增长
+    void walk_on_demand(const json::JsonOnDemand::Value& root, const json::Node* expected) {
+        using json::JsonOnDemand::Type;
+        constexpr size_t max_values = 256;
+        std::vector<std::pair<json::JsonOnDemand::Value, const json::Node*>> stack{{root, expected}};
+        std::string scratch;
+        for (size_t visited = 0; !stack.empty() && visited < max_values; ++visited) {
+            const auto [value, node] = stack.back();
+            stack.pop_back();
+            const auto raw = value.raw();
+            if (node) {
+                const auto reparsed = json::Node::from_str(raw);
+                check(reparsed && reparsed->to_str() == node->to_str());
+            }
+            switch (value.type()) {
+                case Type::Array: {
+                    const auto array = node ? node->get_if<json::ArrayNode>() : nullptr;
+                    check(!node || array);
+                    size_t count = 0;
+                    for (const auto& element : value.elements()) {
+                        stack.emplace_back(element, array && count < array->size() ? &(*array)[count] : nullptr);
+                        ++count;
+                    }
+                    check(!array || count == array->size());
+                    const auto first = value.at(0);
+                    check(!array || first.has_value() == !array->empty());
+                    break;
+                }
+                case Type::Object: {
+                    check(!node || node->is<json::ObjectNode>());
+                    // 重复的键在节点中只保留最后一个值, 所以成员只检查键是否存在, 不与值对照
+                    for (auto it = value.fields().begin(); it != json::JsonOnDemand::ObjectIterator{}; ++it) {
+                        const std::string name{it.name(scratch)};
+                        check(!node || node->find(name) != nullptr);
+                        check(!node || value.find(name).has_value());
+                        stack.emplace_back(it.value(), nullptr);
+                    }
+                    break;
+                }
+                case Type::String: {
+                    const auto str = value.get_string(scratch);
+                    check(!node || (str && node->is<json::StringNode>() && *str == std::string_view{*node->get_if<json::StringNode>()}));
+                    break;
+                }
+                case Type::Number: {
+                    const auto integer = value.as<json::IntNode>();
+                    check(!node || !node->is<json::IntNode>() || integer == node->as<json::IntNode>());
+                    [[maybe_unused]] const auto floating = value.as<json::FloatNode>();
+                    break;
+                }
+                default:
+                    [[maybe_unused]] const auto boolean = value.as<json::BoolNode>();
+                    break;
+            }
+        }
+    }
+
+    // 把任意字节包上合法的文件头, 让 from_binary 的结构检查面对任意的磁带
+    auto forge_image(std::string_view body) -> std::string {
+        using json::JsonTape::Tape;
+        const uint64_t words = body.size() / sizeof(uint64_t);
+        const uint64_t strings = body.size() - words * sizeof(uint64_t);
+        std::string image{Tape::magic};
+        const auto append = [&image](const auto& value) {
+            image.append(reinterpret_cast<const char*>(&value), sizeof value);
+        };
+        append(Tape::version);
+        append(Tape::byte_order);
+        append(words);
+        append(strings);
+        image.append(body);
+        return image;
+    }
+}
+
+JSON_BIND(FuzzRecord, id, name, values, flag, extra);
+
+extern "C" auto LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) -> int {
+    const auto buffer = std::make_unique_for_overwrite<char[]>(size);
+    std::copy_n(data, size, buffer.get());
+    const std::string_view text{buffer.get(), size};
+
+    // Parser 默认是宽松的(逗号、冒号可以省略, 值之后的内容不检查), 严格模式、增量解析器与 validate 是严格的:
+    // 严格合法的输入所有方式都必须接受且结果一致, 严格模式与增量解析器的结论相同, 它们接受的输入
+    // 除了 UTF-8 与字符串中的控制字符之外必须严格合法
+    const auto node = json::Node::from_str(text);
+    const auto verdict = json::validate(text);
+
+    json::JsonParser::Parser packed{text};
+    packed.set_pack_threshold(4);
+    const auto packed_node = packed.parse();
+    check(packed_node.has_value() == node.has_value());
+    // 并行解析接受的输入与串行完全一致
+    const auto parallel = json::JsonParallel::parse(text, {.threads = 2, .min_parallel_bytes = 0});
+    check(parallel.has_value() == node.has_value());
+
+    const auto tape = json::JsonTape::Tape::parse(text);
+    const auto document = json::Document::parse(text);
+
+    // 增量解析在任意位置切块都应得到同样的结果
+    json::JsonStream::IncrementalParser incremental;
+    const auto half = size / 2;
+    const auto streamed = incremental.feed(text.substr(0, half)) && incremental.feed(text.substr(half))
+                              ? incremental.finish()
+                              : std::nullopt;
+    json::JsonParser::Parser strict{text};
+    strict.set_strict(true);
+    const auto strict_node = strict.parse();
+    check(strict_node.has_value() == streamed.has_value());
+    // SAX 与 parse_into 的结论: 宽松的 SAX 与 Parser 一致, 严格的 SAX 与 parse_into<Node> 与严格的 Parser 一致
+    json::JsonParser::NullHandler null_handler;
+    check(json::JsonParser::parse_sax(text, null_handler) == node.has_value());
+    json::JsonParser::SaxParser<json::JsonParser::NullHandler> strict_sax{text, null_handler};
+    strict_sax.set_strict(true);
+    check(strict_sax.parse() == strict_node.has_value());
+    const auto bound_node = json::parse_into<json::Node>(text);
+    check(bound_node.has_value() == strict_node.has_value());
+    check(!bound_node || bound_node->to_str() == strict_node->to_str());
+    // 绑定到结构体的结果序列化后可以原样读回
+    if (const auto record = json::parse_into<FuzzRecord>(text)) {
+        const auto generated = json::generate(*record);
+        const auto again = json::parse_into<FuzzRecord>(generated);
+        check(again && json::generate(*again) == generated);
+    }
+
+    // 按需解析的游标不检查文法, 在任何输入上都只能读到输入之内
+    if (const auto cursor = json::JsonOnDemand::Value::from_str(text)) {
+        walk_on_demand(*cursor, verdict ? &*node : nullptr);
+    }
+
+    // 按行解析: 每条记录与单独解析这一行的结果相同, 有序回调按输入顺序给出同样的记录
+    std::vector<std::optional<json::Node>> lines;
+    json::JsonLines::for_each_line(text, [&](std::string_view line) { lines.push_back(json::Node::from_str(line)); });
+    const auto batch = json::JsonLines::parse(text, {.threads = 2, .min_parallel_bytes = 0});
+    check(batch.records.size() == lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+        check(batch.records[i].has_value() == lines[i].has_value());
+        check(!lines[i] || batch.records[i]->to_str() == lines[i]->to_str());
+    }
+    size_t next_line = 0;
+    const auto summary = json::JsonLines::for_each(text, [&](const json::Node& record, std::string_view) {
+        while (next_line < lines.size() && !lines[next_line]) {
+            ++next_line;
+        }
+        check(next_line < lines.size() && record.to_str() == lines[next_line]->to_str());
+        ++next_line;
+    }, {.threads = 2, .round_bytes = 64, .min_parallel_bytes = 0, .intern_keys = true});
+    check(summary.records + summary.errors == lines.size());
+
+    // 磁带的二进制镜像: 自己写出的镜像一定能读回; 任意内容的镜像要么被结构检查拒绝, 要么能完整遍历
+    if (tape) {
+        check(tape->view().validate());
+        const auto copy = json::JsonTape::Tape::from_binary(tape->to_binary());
+        check(copy && copy->root().to_str() == tape->root().to_str());
+    }
+    if (const auto forged = json::JsonTape::Tape::from_binary(forge_image(text))) {
+        check(forged->view().validate());
+        check(json::Node::from_str(forged->root().to_str()).has_value());
+    }
+
+    if (streamed) {
+        using json::JsonValidate::Error;
+        check(node && (verdict || verdict.error == Error::InvalidUtf8 || verdict.error == Error::InvalidString));
+    }
+    if (verdict) {
+        check(node && streamed);
+    }
+
+    if (node) {
+        // 序列化结果可以原样解析回来, 紧凑数组与磁带的输出与普通节点一致
+        const auto serialized = node->to_str();
+        const auto reparsed = json::Node::from_str(serialized);
+        check(reparsed && reparsed->to_str() == serialized);
+        check(packed_node->to_str() == serialized);
+        check(!streamed || streamed->to_str() == serialized);
+        check(!strict_node || strict_node->to_str() == serialized);
+        // 磁带保留重复的键, 重新解析成节点后才与节点可比
+        check(tape.has_value());
+        const auto from_tape = json::Node::from_str(tape->root().to_str());
+        check(from_tape && from_tape->to_str() == serialized);
+        check(document.has_value());
+        check(parallel && parallel->to_str() == serialized);
+    }
+    return 0;
+}
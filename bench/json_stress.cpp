@@ -0,0 +1,314 @@
+// 对抗性输入下的尾延迟与峰值内存
+// 用法: json_stress [samples] [scale]
+// 每种病态输入用每种解析方式各解析 samples 次, 报告单次解析耗时的 p50/p99/max 与解析期间的峰值堆内存
+// scale 按比例放大或缩小生成的输入, 默认 1 时单个输入约为 1~8MB
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+
+#include "json.hpp"
+
+namespace {
+    // 每块分配前放一个头部记录大小与 malloc 返回的原始指针, 以便在所有 delete 形式中统计释放的字节
+    struct Header {
+        size_t size;
+        void* raw;
+    };
+    constexpr size_t header_size = alignof(std::max_align_t);
+    static_assert(sizeof(Header) <= header_size);
+
+    std::atomic<size_t> live_bytes{0};
+    std::atomic<size_t> peak_bytes{0};
+
+    auto tracked_alloc(size_t size, size_t alignment) -> void* {
+        alignment = std::max(alignment, header_size);
+        const auto raw = static_cast<char*>(std::malloc(size + alignment));
+        if (raw == nullptr) {
+            throw std::bad_alloc{};
+        }
+        const auto ptr = raw + alignment;
+        new (ptr - header_size) Header{size, raw};
+        const auto live = live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+        auto peak = peak_bytes.load(std::memory_order_relaxed);
+        while (live > peak && !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+        return ptr;
+    }
+    void tracked_free(void* ptr) noexcept {
+        if (ptr == nullptr) {
+            return;
+        }
+        const auto header = reinterpret_cast<Header*>(static_cast<char*>(ptr) - header_size);
+        live_bytes.fetch_sub(header->size, std::memory_order_relaxed);
+        std::free(header->raw);
+    }
+}
+
+auto operator new(size_t size) -> void* { return tracked_alloc(size, 0); }
+auto operator new[](size_t size) -> void* { return tracked_alloc(size, 0); }
+auto operator new(size_t size, std::align_val_t align) -> void* { return tracked_alloc(size, static_cast<size_t>(align)); }
+auto operator new[](size_t size, std::align_val_t align) -> void* { return tracked_alloc(size, static_cast<size_t>(align)); }
+void operator delete(void* ptr) noexcept { tracked_free(ptr); }
+void operator delete[](void* ptr) noexcept { tracked_free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { tracked_free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { tracked_free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { tracked_free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { tracked_free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { tracked_free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { tracked_free(ptr); }
+
+namespace {
+    // 一种病态输入; 有多个变体(如不同位置的截断)时各次采样轮流使用
+    struct Shape {
+        std::string name;
+        std::vector<std::string> inputs;
+    };
+
+    auto repeat(std::string_view unit, size_t count) -> std::string {
+        std::string out;
+        out.reserve(unit.size() * count);
+        for (size_t i = 0; i < count; ++i) {
+            out += unit;
+        }
+        return out;
+    }
+
+    auto make_shapes(double scale) -> std::vector<Shape> {
+        const auto n = [scale](size_t count) { return std::max<size_t>(1, static_cast<size_t>(static_cast<double>(count) * scale)); };
+        std::mt19937 rng{42};
+        std::vector<Shape> shapes;
+
+        // 嵌套: 恰在默认深度限制之内, 以及远超限制(应当快速拒绝)
+        const auto depth = json::JsonParser::default_max_depth;
+        shapes.push_back({"deep arrays", {repeat("[", depth) + repeat("]", depth)}});
+        shapes.push_back({"deep objects", {repeat(R"({"k":)", depth - 1) + "{}" + repeat("}", depth - 1)}});
+        shapes.push_back({"too deep", {repeat("[", n(1 << 20))}});
+
+        // 长字符串: 无转义、满是转义、满是多字节字符
+        shapes.push_back({"huge string", {'"' + std::string(n(8 << 20), 'a') + '"'}});
+        shapes.push_back({"escaped string", {'"' + repeat(R"(\n\"\\é😀)", n(1 << 17)) + '"'}});
+        shapes.push_back({"utf-8 string", {'"' + repeat("\xe5\x90\x8d\xf0\x9f\x98\x80", n(1 << 18)) + '"'}});
+        // 未结束的字符串: 结构索引与扫描都要走到输入末尾才能确定失败
+        shapes.push_back({"unterminated string", {'"' + repeat(R"(abc\")", n(1 << 20))}});
+
+        // 长数字串: 超长整数、超长小数、大量需要完整 strtod 的数字
+        shapes.push_back({"long integer", {std::string(n(1 << 20), '9')}});
+        shapes.push_back({"long fraction", {"0." + std::string(n(1 << 20), '7')}});
+        shapes.push_back({"long exponent", {"1e" + std::string(n(1 << 20), '0') + "1"}});
+        {
+            std::string out = "[";
+            for (size_t i = 0; i < n(1 << 17); ++i) {
+                out += (i ? "," : "") + std::to_string(rng()) + '.' + std::to_string(rng()) + std::to_string(rng()) + "e-3";
+            }
+            shapes.push_back({"hard floats", {out + "]"}});
+        }
+
+        // 对象: 全部重复的键, 与大量不同的键(对象内索引的最坏情况)
+        {
+            std::string same = "{", distinct = "{";
+            for (size_t i = 0; i < n(1 << 17); ++i) {
+                same += (i ? "," : "") + std::string{R"("key":)"} + std::to_string(i);
+                distinct += (i ? ",\"" : "\"") + std::to_string(rng()) + "_" + std::to_string(i) + "\":" + std::to_string(i);
+            }
+            shapes.push_back({"duplicate keys", {same + "}"}});
+            shapes.push_back({"distinct keys", {distinct + "}"}});
+        }
+
+        // 宽数组: 大量极小的值
+        shapes.push_back({"wide array", {"[" + repeat("0,", n(1 << 21)) + "0]"}});
+        shapes.push_back({"wide empty containers", {"[" + repeat("{},[],", n(1 << 19)) + "null]"}});
+
+        // 截断的正常文档: 在 64 个等分点截断, 每次采样换一个截断点
+        {
+            std::string document = "[";
+            for (size_t i = 0; i < n(1 << 13); ++i) {
+                document += (i ? "," : "") + std::string{R"({"id":)"} + std::to_string(i) +
+                            R"(,"name":"item é \"quoted\"","price":)" + std::to_string(rng() % 100000) +
+                            R"(.25,"tags":["a","b",null,true],"nested":{"x":[1,2,{"y":false}]}})";
+            }
+            document += "]";
+            Shape truncated{"truncated", {}};
+            for (size_t i = 1; i <= 64; ++i) {
+                truncated.inputs.push_back(document.substr(0, document.size() * i / 65));
+            }
+            shapes.push_back(std::move(truncated));
+        }
+        return shapes;
+    }
+
+    // 防止编译器把解析整个优化掉
+    template<typename T>
+    void keep(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    template<typename T>
+    auto accepted(const std::optional<T>& result) -> bool {
+        return result.has_value();
+    }
+    auto accepted(const json::JsonValidate::Result& result) -> bool {
+        return static_cast<bool>(result);
+    }
+    auto accepted(bool result) -> bool {
+        return result;
+    }
+    // 每条记录都解析成功才算接受
+    auto accepted(const json::JsonLines::Batch& batch) -> bool {
+        return std::all_of(batch.records.begin(), batch.records.end(), [](const auto& record) { return record.has_value(); });
+    }
+
+    struct Mode {
+        const char* name;
+        // 解析一次, 返回输入是否被接受; elapsed 不含结果的析构
+        bool (*run)(std::string_view text, std::chrono::nanoseconds& elapsed);
+    };
+
+    template<auto Parse>
+    auto timed(std::string_view text, std::chrono::nanoseconds& elapsed) -> bool {
+        const auto start = std::chrono::steady_clock::now();
+        const auto result = Parse(text);
+        elapsed = std::chrono::steady_clock::now() - start;
+        keep(result);
+        return accepted(result);
+    }
+
+    // 按需游标的典型用法: 取根的完整文本, 再逐个访问顶层的元素或成员并查找一个键
+    // 只走一层, 每个值只被跳过常数次; 游标不检查文法, 根不完整时判为拒绝
+    auto on_demand_scan(std::string_view text) -> std::optional<size_t> {
+        using json::JsonOnDemand::Type;
+        const auto root = json::JsonOnDemand::Value::from_str(text);
+        if (!root || root->raw().empty()) {
+            return {};
+        }
+        size_t bytes = 0;
+        if (root->type() == Type::Array) {
+            for (const auto& element : root->elements()) {
+                bytes += element.raw().size();
+            }
+        } else if (root->type() == Type::Object) {
+            for (auto it = root->fields().begin(); it != json::JsonOnDemand::ObjectIterator{}; ++it) {
+                bytes += it.value().raw().size();
+            }
+            bytes += root->find("id").has_value();
+        }
+        return bytes;
+    }
+
+    // 从二进制镜像读回磁带, 只计 from_binary(含 View::validate)的时间; 峰值内存包含镜像本身, 不含准备它时的解析
+    // 磁带解析不了的输入换成包上文件头的原始字节, 测量结构检查拒绝任意内容的代价
+    auto time_from_binary(std::string_view text, std::chrono::nanoseconds& elapsed) -> bool {
+        using json::JsonTape::Tape;
+        std::string image;
+        if (const auto tape = Tape::parse(text)) {
+            image = tape->to_binary();
+        } else {
+            const uint64_t words = text.size() / sizeof(uint64_t);
+            const uint64_t strings = text.size() - words * sizeof(uint64_t);
+            image = Tape::magic;
+            const auto append = [&image](const auto& value) {
+                image.append(reinterpret_cast<const char*>(&value), sizeof value);
+            };
+            append(Tape::version);
+            append(Tape::byte_order);
+            append(words);
+            append(strings);
+            image.append(text);
+        }
+        peak_bytes.store(live_bytes.load());
+        const auto start = std::chrono::steady_clock::now();
+        const auto result = Tape::from_binary(image);
+        elapsed = std::chrono::steady_clock::now() - start;
+        keep(result);
+        return accepted(result);
+    }
+
+    const Mode modes[] = {
+        {"Node::from_str", timed<[](std::string_view text) { return json::Node::from_str(text); }>},
+        {"Document::parse", timed<[](std::string_view text) { return json::Document::parse(text); }>},
+        {"Parser packed arrays", timed<[](std::string_view text) {
+            json::JsonParser::Parser parser{text};
+            parser.set_pack_threshold(16);
+            return parser.parse();
+        }>},
+        {"Tape::parse", timed<[](std::string_view text) { return json::JsonTape::Tape::parse(text); }>},
+        {"JsonParallel::parse", timed<[](std::string_view text) {
+            return json::JsonParallel::parse(text, {.threads = 4, .min_parallel_bytes = 0});
+        }>},
+        {"IncrementalParser", timed<[](std::string_view text) {
+            json::JsonStream::IncrementalParser parser;
+            for (size_t offset = 0; offset < text.size(); offset += 64 * 1024) {
+                if (!parser.feed(text.substr(offset, 64 * 1024))) {
+                    return std::optional<json::Node>{};
+                }
+            }
+            return parser.finish();
+        }>},
+        {"validate", timed<[](std::string_view text) { return json::validate(text); }>},
+        {"parse_sax NullHandler", timed<[](std::string_view text) {
+            json::JsonParser::NullHandler handler;
+            return json::JsonParser::parse_sax(text, handler);
+        }>},
+        {"parse_into<Node>", timed<[](std::string_view text) { return json::parse_into<json::Node>(text); }>},
+        {"OnDemand scan", timed<on_demand_scan>},
+        {"JsonLines::parse", timed<[](std::string_view text) {
+            return json::JsonLines::parse(text, {.threads = 4, .min_parallel_bytes = 0});
+        }>},
+        {"Tape::from_binary", time_from_binary},
+    };
+
+    auto percentile(const std::vector<double>& sorted, double p) -> double {
+        const auto rank = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[rank];
+    }
+
+    void run_shape(const Shape& shape, size_t samples) {
+        size_t bytes = 0;
+        for (const auto& input : shape.inputs) {
+            bytes = std::max(bytes, input.size());
+        }
+        for (const auto& mode : modes) {
+            std::vector<double> micros;
+            micros.reserve(samples);
+            size_t peak = 0;
+            size_t accepted_count = 0;
+            std::chrono::nanoseconds elapsed{};
+            mode.run(shape.inputs.front(), elapsed);  // 预热, 让惰性初始化不计入结果
+            for (size_t i = 0; i < samples; ++i) {
+                const auto& input = shape.inputs[i % shape.inputs.size()];
+                const auto baseline = live_bytes.load();
+                peak_bytes.store(baseline);
+                accepted_count += mode.run(input, elapsed);
+                micros.push_back(std::chrono::duration<double, std::micro>(elapsed).count());
+                peak = std::max(peak, peak_bytes.load() - baseline);
+            }
+            std::sort(micros.begin(), micros.end());
+            char line[256];
+            std::snprintf(line, sizeof line, "%-22s %-22s %8.2f %12.1f %12.1f %12.1f %10.2f %8.2f %3zu/%zu", shape.name.c_str(), mode.name,
+                          static_cast<double>(bytes) / 1e6, percentile(micros, 0.5), percentile(micros, 0.99), micros.back(),
+                          static_cast<double>(peak) / 1e6, static_cast<double>(peak) / static_cast<double>(std::max<size_t>(bytes, 1)),
+                          accepted_count, samples);
+            std::cout << line << '\n';
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    const size_t samples = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+    const double scale = argc > 2 ? std::atof(argv[2]) : 1.0;
+
+    const auto shapes = make_shapes(scale);
+    std::cout << "scan kernels: " << json::JsonScan::kernels().name << '\n';
+    char header[256];
+    std::snprintf(header, sizeof header, "%-22s %-22s %8s %12s %12s %12s %10s %8s %s", "input", "mode", "MB", "p50 us", "p99 us",
+                  "max us", "peak MB", "peak/in", "ok");
+    std::cout << header << '\n';
+    for (const auto& shape : shapes) {
+        run_shape(shape, samples);
+    }
+    return 0;
+}
@@ -0,0 +1,7039 @@
+#pragma once
+
+#include <iostream>
+
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+#include <stdexcept>
+#include <functional>
+#include <vector>
+#include <string>
+#include <utility>
+#include <variant>
+#include <optional>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <iterator>
+#include <algorithm>
+#include <concepts>
+#include <bit>
+#include <cmath>
+#include <charconv>
+#include <string_view>
+#include <filesystem>
+#include <tuple>
+#include <array>
+#include <span>
+#include <type_traits>
+#include <fstream>
+#include <chrono>
+#include <coroutine>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define JSON_HAS_MMAP 1
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#define JSON_HAS_SSE2 1
+#if defined(__GNUC__) || defined(__clang__)
+#define JSON_HAS_AVX2 1
+#endif
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define JSON_HAS_NEON 1
+#endif
+
+namespace json {
+    namespace JsonMemory {
+        // 累计计数, 用于确认稳态解析时不再向上游申请内存
+        struct ArenaStats {
+            size_t allocations = 0;           // 经由 arena 的分配次数
+            size_t bytes = 0;                 // 经由 arena 分配的字节数
+            size_t upstream_allocations = 0;  // 向上游申请内存块的次数
+            size_t upstream_bytes = 0;        // 向上游申请的字节数
+        };
+
+        // 单调增长的 arena: 释放单个对象是空操作, reset 时整体回卷并保留已申请的内存
+        // 超过 large_threshold 的请求(典型的是宽数组反复扩容的缓冲区)各自单独向上游申请, 不占用也不放大普通块:
+        // 释放的大块留作备用, 之后大小相近(不超过块的一倍)的请求直接复用; 不得不新申请时先归还比请求小的备用块,
+        // 所以扩容途中被换下的缓冲区不会累积, 峰值内存与直接使用堆相当; reset 时归还整轮都没被用到的备用块
+        // 大字符串等一次分配到位的值在稳态下不再向上游申请, 逐步扩容的宽数组每轮仍会为中间大小的缓冲区申请
+        class Arena : public std::pmr::memory_resource {
+        public:
+            static constexpr size_t large_threshold = 32 * 1024;
+        protected:
+            struct Block {
+                Block* next;
+                size_t size;  // 不含块头的可用字节数
+            };
+            // 单独申请的大块, 在使用中或备用的双向链表里; 数据紧跟在按对齐取整的块头之后
+            struct Large {
+                Large* prev;
+                Large* next;
+                size_t size;       // 不含块头的可用字节数
+                size_t alignment;  // 申请时的对齐, 只复用给同样对齐的请求
+                size_t round;      // 最近一次被使用时的轮次
+                bool live;         // 在使用中的链表里; reset 之后才析构的对象归还的块已经是备用块, 不再处理
+            };
+
+            std::pmr::memory_resource* upstream;
+            Block* blocks = nullptr;
+            char* cursor = nullptr;
+            char* limit = nullptr;
+            size_t next_size;
+            Large* large = nullptr;  // 使用中的大块
+            Large* spare = nullptr;  // 已释放或 reset 后留作复用的大块
+            size_t rounds = 0;       // reset 的次数
+            ArenaStats counters;
+
+            static auto data(Block* block) -> char* {
+                return reinterpret_cast<char*>(block + 1);
+            }
+            static auto large_alignment(size_t alignment) -> size_t {
+                return std::max(alignment, alignof(std::max_align_t));
+            }
+            static auto large_header(size_t alignment) -> size_t {
+                return (sizeof(Large) + alignment - 1) / alignment * alignment;
+            }
+            static auto data(Large* block) -> char* {
+                return reinterpret_cast<char*>(block) + large_header(block->alignment);
+            }
+
+            static void unlink(Large*& list, Large* block) {
+                (block->prev ? block->prev->next : list) = block->next;
+                if (block->next) block->next->prev = block->prev;
+            }
+            static void link(Large*& list, Large* block) {
+                block->prev = nullptr;
+                block->next = list;
+                if (list) list->prev = block;
+                list = block;
+            }
+
+            void add_block(size_t size) {
+                const auto total = sizeof(Block) + size;
+                auto block = static_cast<Block*>(upstream->allocate(total, alignof(std::max_align_t)));
+                block->next = blocks;
+                block->size = size;
+                blocks = block;
+                cursor = data(block);
+                limit = cursor + size;
+                ++counters.upstream_allocations;
+                counters.upstream_bytes += total;
+            }
+
+            void free_large(Large* block) {
+                upstream->deallocate(block, large_header(block->alignment) + block->size, block->alignment);
+            }
+            void free_list(Large*& list) {
+                while (list != nullptr) {
+                    const auto next = list->next;
+                    free_large(list);
+                    list = next;
+                }
+            }
+
+            void free_blocks() {
+                while (blocks != nullptr) {
+                    const auto next = blocks->next;
+                    upstream->deallocate(blocks, sizeof(Block) + blocks->size, alignof(std::max_align_t));
+                    blocks = next;
+                }
+                cursor = limit = nullptr;
+            }
+            void free_all() {
+                free_blocks();
+                free_list(large);
+                free_list(spare);
+            }
+
+            // 优先复用备用块中能容纳请求、且不超过请求一倍的最小者, 没有时才向上游申请
+            auto allocate_large(size_t bytes, size_t alignment) -> void* {
+                alignment = large_alignment(alignment);
+                Large* best = nullptr;
+                for (auto block = spare; block != nullptr; block = block->next) {
+                    if (block->alignment == alignment && block->size >= bytes && block->size / 2 <= bytes &&
+                        (!best || block->size < best->size)) {
+                        best = block;
+                    }
+                }
+                if (best) {
+                    unlink(spare, best);
+                } else {
+                    for (auto block = spare; block != nullptr;) {
+                        const auto next = block->next;
+                        if (block->size < bytes) {
+                            unlink(spare, block);
+                            free_large(block);
+                        }
+                        block = next;
+                    }
+                    const auto total = large_header(alignment) + bytes;
+                    best = static_cast<Large*>(upstream->allocate(total, alignment));
+                    best->size = bytes;
+                    best->alignment = alignment;
+                    ++counters.upstream_allocations;
+                    counters.upstream_bytes += total;
+                }
+                best->live = true;
+                best->round = rounds;
+                link(large, best);
+                return data(best);
+            }
+
+            auto do_allocate(size_t bytes, size_t alignment) -> void* override {
+                ++counters.allocations;
+                counters.bytes += bytes;
+                if (bytes > large_threshold) {
+                    return allocate_large(bytes, alignment);
+                }
+                auto space = static_cast<size_t>(limit - cursor);
+                void* ptr = cursor;
+                if (cursor == nullptr || std::align(alignment, bytes, ptr, space) == nullptr) {
+                    while (next_size < bytes + alignment) {
+                        next_size *= 2;
+                    }
+                    add_block(next_size);
+                    next_size *= 2;
+                    ptr = cursor;
+                    space = static_cast<size_t>(limit - cursor);
+                    std::align(alignment, bytes, ptr, space);
+                }
+                cursor = static_cast<char*>(ptr) + bytes;
+                return ptr;
+            }
+
+            // 普通块中的对象不单独释放; 大块转入备用
+            void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+                if (bytes <= large_threshold) {
+                    return;
+                }
+                alignment = large_alignment(alignment);
+                const auto block = reinterpret_cast<Large*>(static_cast<char*>(ptr) - large_header(alignment));
+                if (!block->live) {
+                    return;
+                }
+                unlink(large, block);
+                block->live = false;
+                link(spare, block);
+            }
+
+            [[nodiscard]] auto do_is_equal(const std::pmr::memory_resource& rhs) const noexcept -> bool override {
+                return this == &rhs;
+            }
+        public:
+            explicit Arena(size_t initial_size = 4096,
+                           std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+                : upstream(upstream), next_size(std::max<size_t>(initial_size, 64)) {}
+            Arena(const Arena&) = delete;
+            auto operator=(const Arena&) -> Arena& = delete;
+            ~Arena() override {
+                free_all();
+            }
+
+            // 回卷到起点, 之前分配的对象全部失效
+            // 如果上一轮用了多个块, 合并成一个足够大的块, 之后同等规模的输入不再向上游申请内存
+            // 仍在使用的大块转为备用; 这一轮没被用到的备用块归还上游, 备用块的总量不超过最近一轮的需要
+            void reset() {
+                for (auto block = spare; block != nullptr;) {
+                    const auto next = block->next;
+                    if (block->round != rounds) {
+                        unlink(spare, block);
+                        free_large(block);
+                    }
+                    block = next;
+                }
+                while (large != nullptr) {
+                    const auto block = large;
+                    unlink(large, block);
+                    block->live = false;
+                    link(spare, block);
+                }
+                ++rounds;
+                if (blocks == nullptr) {
+                    return;
+                }
+                if (blocks->next != nullptr) {
+                    size_t total = 0;
+                    for (auto block = blocks; block != nullptr; block = block->next) {
+                        total += block->size;
+                    }
+                    free_blocks();
+                    add_block(total);
+                    next_size = total * 2;
+                    return;
+                }
+                cursor = data(blocks);
+                limit = cursor + blocks->size;
+            }
+
+            // 归还所有内存
+            void release() {
+                free_all();
+            }
+
+            [[nodiscard]] auto stats() const -> const ArenaStats& {
+                return counters;
+            }
+        };
+
+        struct AllocationStats {
+            size_t allocations = 0;
+            size_t bytes = 0;
+            size_t deallocations = 0;
+            size_t live_bytes = 0;  // 尚未归还的字节数
+        };
+
+        // 统计经由它的分配, 实际分配交给上游; 用来观察任意 memory_resource 上的分配次数与字节数
+        // 计数不是原子的, 不要在多个线程间共享
+        class CountingResource : public std::pmr::memory_resource {
+        protected:
+            std::pmr::memory_resource* upstream;
+            AllocationStats counters;
+
+            auto do_allocate(size_t bytes, size_t alignment) -> void* override {
+                auto ptr = upstream->allocate(bytes, alignment);
+                ++counters.allocations;
+                counters.bytes += bytes;
+                counters.live_bytes += bytes;
+                return ptr;
+            }
+            void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+                upstream->deallocate(ptr, bytes, alignment);
+                ++counters.deallocations;
+                counters.live_bytes -= bytes;
+            }
+            [[nodiscard]] auto do_is_equal(const std::pmr::memory_resource& rhs) const noexcept -> bool override {
+                return this == &rhs;
+            }
+        public:
+            explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+                : upstream(upstream) {}
+
+            [[nodiscard]] auto stats() const -> const AllocationStats& {
+                return counters;
+            }
+        };
+    }
+
+    namespace JsonNode {
+        // 代表json节点的结构体
+        class Node;
+
+        // 空状态
+        using MonoNode = std::monostate;
+
+        // 以下是json中的各种基础数据类型
+        using BoolNode = bool;
+        using IntNode = int64_t;
+        using FloatNode = double;
+        // 字符串与复合类型均使用 std::pmr 容器, 默认走全局堆, 也可以整棵树分配在同一块 arena 上
+        using StringNode = std::pmr::string;
+
+        // 对象的键: 指向驻留池中共享的字符串, 或者指向所在对象用自己的分配器申请的副本
+        // 只是一个句柄, 副本的生命周期由 OrderedObject 管理
+        class Key {
+        protected:
+            const char* ptr = "";
+            uint32_t length = 0;
+            uint32_t pool = 0;  // 所属驻留池的编号, 0 表示不是驻留字符串
+        public:
+            // 长度只有 32 位; 驻留与复制时超出的键抛出 std::length_error, 解析时直接判为失败
+            static constexpr size_t max_size = UINT32_MAX;
+
+            Key() = default;
+            // length 不得超过 max_size, 由创建键的一方检查
+            Key(const char* ptr, size_t length, uint32_t pool)
+                : ptr(ptr), length(static_cast<uint32_t>(length)), pool(pool) {}
+
+            [[nodiscard]] auto data() const -> const char* { return ptr; }
+            [[nodiscard]] auto size() const -> size_t { return length; }
+            [[nodiscard]] auto is_interned() const -> bool { return pool != 0; }
+            [[nodiscard]] auto pool_id() const -> uint32_t { return pool; }
+            [[nodiscard]] auto view() const -> std::string_view { return {ptr, length}; }
+            operator std::string_view() const { return view(); }
+
+            // 同一个池中内容相同的键地址也相同, 所以只比较指针; 其他情况退回逐字节比较
+            friend auto operator==(const Key& lhs, const Key& rhs) -> bool {
+                if (lhs.ptr == rhs.ptr && lhs.length == rhs.length) {
+                    return true;
+                }
+                if (lhs.pool != 0 && lhs.pool == rhs.pool) {
+                    return false;
+                }
+                return lhs.view() == rhs.view();
+            }
+            friend auto operator==(const Key& lhs, std::string_view rhs) -> bool {
+                return lhs.view() == rhs;
+            }
+        };
+
+        // 键的驻留池: 相同内容只保存一份, 供多个文档的对象共享
+        // 池必须比引用它的节点活得久; 不是线程安全的, 并行解析时每个线程各用一个
+        class KeyPool {
+        protected:
+            JsonMemory::Arena storage;
+            // 开放寻址表, 空槽的 data 为 nullptr
+            std::vector<Key> slots;
+            size_t count = 0;
+            uint32_t id;
+
+            static auto next_id() -> uint32_t {
+                static std::atomic<uint32_t> counter{0};
+                return ++counter;
+            }
+            static auto hash(std::string_view key) -> size_t {
+                return std::hash<std::string_view>{}(key);
+            }
+            [[nodiscard]] auto find_slot(std::string_view key) const -> size_t {
+                const auto mask = slots.size() - 1;
+                auto slot = hash(key) & mask;
+                while (slots[slot].data() != nullptr && slots[slot].view() != key) {
+                    slot = (slot + 1) & mask;
+                }
+                return slot;
+            }
+            void grow() {
+                auto old = std::move(slots);
+                slots.assign(old.size() * 2, Key{nullptr, 0, 0});
+                for (const auto& key : old) {
+                    if (key.data() != nullptr) {
+                        slots[find_slot(key.view())] = key;
+                    }
+                }
+            }
+        public:
+            explicit KeyPool(size_t initial_size = 4096)
+                : storage(initial_size), slots(64, Key{nullptr, 0, 0}), id(next_id()) {}
+            KeyPool(const KeyPool&) = delete;
+            auto operator=(const KeyPool&) -> KeyPool& = delete;
+
+            // 返回 key 在池中的句柄, 第一次出现时复制进池
+            auto intern(std::string_view key) -> Key {
+                if (key.size() > Key::max_size) {
+                    throw std::length_error("json key too long");
+                }
+                auto slot = find_slot(key);
+                if (slots[slot].data() != nullptr) {
+                    return slots[slot];
+                }
+                if ((count + 1) * 2 > slots.size()) {
+                    grow();
+                    slot = find_slot(key);
+                }
+                auto data = static_cast<char*>(storage.allocate(std::max<size_t>(key.size(), 1), 1));
+                std::copy(key.begin(), key.end(), data);
+                ++count;
+                return slots[slot] = Key{data, key.size(), id};
+            }
+            // 只查找不插入, 用于按池中的句柄查询对象
+            [[nodiscard]] auto find(std::string_view key) const -> std::optional<Key> {
+                const auto slot = find_slot(key);
+                if (slots[slot].data() == nullptr) {
+                    return {};
+                }
+                return slots[slot];
+            }
+
+            [[nodiscard]] auto size() const -> size_t { return count; }
+            [[nodiscard]] auto stats() const -> JsonMemory::ArenaStats { return storage.stats(); }
+        };
+
+        // 按插入顺序保存成员的扁平对象: 成员连续存放, 成员较少时线性查找, 超过阈值后建立哈希索引
+        // 键可以是驻留池中的句柄(不占对象的内存), 也可以是对象自己持有的副本
+        template<typename Value>
+        class OrderedObject {
+        public:
+            using key_type = Key;
+            using mapped_type = Value;
+            using value_type = std::pair<Key, Value>;
+            using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+            using iterator = typename std::pmr::vector<value_type>::iterator;
+            using const_iterator = typename std::pmr::vector<value_type>::const_iterator;
+
+            // 成员数达到该值后才建立哈希索引
+            static constexpr size_t index_threshold = 16;
+        protected:
+            std::pmr::vector<value_type> members;
+            // 开放寻址的索引表, 槽中存放成员下标 + 1, 0 表示空槽
+            std::pmr::vector<uint32_t> index;
+
+            static auto hash(std::string_view key) -> size_t {
+                return std::hash<std::string_view>{}(key);
+            }
+
+            template<typename K>
+            [[nodiscard]] auto find_position(const K& key) const -> size_t {
+                if (index.empty()) {
+                    for (size_t i = 0; i < members.size(); ++i) {
+                        if (members[i].first == key) {
+                            return i;
+                        }
+                    }
+                    return members.size();
+                }
+                const auto mask = index.size() - 1;
+                for (auto slot = hash(key) & mask; index[slot] != 0; slot = (slot + 1) & mask) {
+                    const auto position = index[slot] - 1;
+                    if (members[position].first == key) {
+                        return position;
+                    }
+                }
+                return members.size();
+            }
+
+            void index_member(size_t position) {
+                const auto mask = index.size() - 1;
+                auto slot = hash(members[position].first) & mask;
+                while (index[slot] != 0) {
+                    slot = (slot + 1) & mask;
+                }
+                index[slot] = static_cast<uint32_t>(position + 1);
+            }
+
+            void rebuild_index() {
+                index.clear();
+                if (members.size() < index_threshold) {
+                    return;
+                }
+                size_t capacity = index_threshold * 2;
+                while (capacity < members.size() * 2) {
+                    capacity *= 2;
+                }
+                index.assign(capacity, 0);
+                for (size_t i = 0; i < members.size(); ++i) {
+                    index_member(i);
+                }
+            }
+
+            // 驻留的键直接共享, 其余的键复制一份到对象的分配器上
+            auto own(const Key& key) -> Key {
+                return key.is_interned() ? key : own(key.view());
+            }
+            auto own(std::string_view key) -> Key {
+                if (key.empty()) {
+                    return {};
+                }
+                if (key.size() > Key::max_size) {
+                    throw std::length_error("json key too long");
+                }
+                std::pmr::polymorphic_allocator<char> alloc{members.get_allocator().resource()};
+                const auto data = alloc.allocate(key.size());
+                std::copy(key.begin(), key.end(), data);
+                return {data, key.size(), 0};
+            }
+            void release(const Key& key) {
+                if (!key.is_interned() && key.size() != 0) {
+                    std::pmr::polymorphic_allocator<char> alloc{members.get_allocator().resource()};
+                    alloc.deallocate(const_cast<char*>(key.data()), key.size());
+                }
+            }
+            void release_all() {
+                for (const auto& member : members) {
+                    release(member.first);
+                }
+            }
+
+            // 追加一个确定不存在的键, 并按需维护索引
+            template<typename K, typename... Args>
+            auto append(const K& key, Args&&... args) -> iterator {
+                const auto owned = own(key);
+                try {
+                    members.emplace_back(std::piecewise_construct,
+                                         std::forward_as_tuple(owned),
+                                         std::forward_as_tuple(std::forward<Args>(args)...));
+                } catch (...) {
+                    release(owned);
+                    throw;
+                }
+                if (members.size() >= index_threshold && members.size() * 2 > index.size()) {
+                    rebuild_index();
+                } else if (!index.empty()) {
+                    index_member(members.size() - 1);
+                }
+                return members.end() - 1;
+            }
+
+            void copy_from(const OrderedObject& other) {
+                members.reserve(other.size());
+                for (const auto& [key, value] : other.members) {
+                    append(key, value);
+                }
+            }
+        public:
+            OrderedObject() = default;
+            explicit OrderedObject(const allocator_type& alloc) : members(alloc), index(alloc) {}
+
+            // 与 std::pmr 容器一致: 拷贝构造使用默认资源, 移动构造沿用原分配器
+            OrderedObject(const OrderedObject& other) {
+                copy_from(other);
+            }
+            OrderedObject(OrderedObject&& other) noexcept
+                : members(std::move(other.members)), index(std::move(other.index)) {
+                other.members.clear();
+                other.index.clear();
+            }
+            // 赋值保留自己的分配器; 分配器不同时键必须重新复制
+            auto operator=(const OrderedObject& other) -> OrderedObject& {
+                if (this != &other) {
+                    clear();
+                    copy_from(other);
+                }
+                return *this;
+            }
+            auto operator=(OrderedObject&& other) -> OrderedObject& {
+                if (this == &other) {
+                    return *this;
+                }
+                if (get_allocator() != other.get_allocator()) {
+                    *this = static_cast<const OrderedObject&>(other);
+                    other.clear();
+                    return *this;
+                }
+                release_all();
+                members = std::move(other.members);
+                index = std::move(other.index);
+                other.members.clear();
+                other.index.clear();
+                return *this;
+            }
+            ~OrderedObject() {
+                release_all();
+            }
+
+            [[nodiscard]] auto get_allocator() const -> allocator_type {
+                return members.get_allocator();
+            }
+
+            [[nodiscard]] auto size() const -> size_t { return members.size(); }
+            [[nodiscard]] auto empty() const -> bool { return members.empty(); }
+            void reserve(size_t count) { members.reserve(count); }
+            void clear() {
+                release_all();
+                members.clear();
+                index.clear();
+            }
+
+            auto begin() -> iterator { return members.begin(); }
+            auto end() -> iterator { return members.end(); }
+            [[nodiscard]] auto begin() const -> const_iterator { return members.begin(); }
+            [[nodiscard]] auto end() const -> const_iterator { return members.end(); }
+
+            // 以下查找接口都有 std::string_view 与 Key 两个版本, 后者对驻留的键只比较指针
+            auto find(std::string_view key) -> iterator {
+                return members.begin() + static_cast<std::ptrdiff_t>(find_position(key));
+            }
+            auto find(const Key& key) -> iterator {
+                return members.begin() + static_cast<std::ptrdiff_t>(find_position(key));
+            }
+            [[nodiscard]] auto find(std::string_view key) const -> const_iterator {
+                return members.begin() + static_cast<std::ptrdiff_t>(find_position(key));
+            }
+            [[nodiscard]] auto find(const Key& key) const -> const_iterator {
+                return members.begin() + static_cast<std::ptrdiff_t>(find_position(key));
+            }
+            [[nodiscard]] auto contains(std::string_view key) const -> bool {
+                return find_position(key) != members.size();
+            }
+
+            auto at(std::string_view key) -> Value& {
+                if (auto it = find(key); it != end()) {
+                    return it->second;
+                }
+                throw std::out_of_range("no such key");
+            }
+            [[nodiscard]] auto at(std::string_view key) const -> const Value& {
+                if (auto it = find(key); it != end()) {
+                    return it->second;
+                }
+                throw std::out_of_range("no such key");
+            }
+
+            auto operator[](std::string_view key) -> Value& {
+                return try_emplace(key).first->second;
+            }
+            auto operator[](const Key& key) -> Value& {
+                return try_emplace(key).first->second;
+            }
+
+            template<typename... Args>
+            auto try_emplace(std::string_view key, Args&&... args) -> std::pair<iterator, bool> {
+                if (auto it = find(key); it != end()) {
+                    return {it, false};
+                }
+                return {append(key, std::forward<Args>(args)...), true};
+            }
+            template<typename... Args>
+            auto try_emplace(const Key& key, Args&&... args) -> std::pair<iterator, bool> {
+                if (auto it = find(key); it != end()) {
+                    return {it, false};
+                }
+                return {append(key, std::forward<Args>(args)...), true};
+            }
+
+            // 重复的键保留最后一次出现的值, 位置保持第一次出现时的位置
+            auto insert_or_assign(std::string_view key, Value&& value) -> std::pair<iterator, bool> {
+                if (auto it = find(key); it != end()) {
+                    it->second = std::move(value);
+                    return {it, false};
+                }
+                return {append(key, std::move(value)), true};
+            }
+
+            // 删除时保持剩余成员的相对顺序
+            auto erase(std::string_view key) -> size_t {
+                const auto position = find_position(key);
+                if (position == members.size()) {
+                    return 0;
+                }
+                release(members[position].first);
+                members.erase(members.begin() + static_cast<std::ptrdiff_t>(position));
+                rebuild_index();
+                return 1;
+            }
+            // 在 position 处插入一个确定不存在的键, 原来在此及之后的成员依次后移; 用于撤销 erase
+            template<typename K>
+            auto insert_at(size_t position, const K& key, Value&& value) -> iterator {
+                const auto owned = own(key);
+                iterator it;
+                try {
+                    it = members.emplace(members.begin() + static_cast<std::ptrdiff_t>(position), std::piecewise_construct,
+                                         std::forward_as_tuple(owned), std::forward_as_tuple(std::move(value)));
+                } catch (...) {
+                    release(owned);
+                    throw;
+                }
+                rebuild_index();
+                return it;
+            }
+        };
+
+        // 以下是json中的复合类型
+        using ArrayNode = std::pmr::vector<Node>;
+        using ObjectNode = OrderedObject<Node>;
+        // 元素全是整数或全是浮点数的数组可以紧凑存放, 每个元素只占 8 字节; 只有开启后解析器才会生成
+        // 紧凑数组的元素不是 Node, 通过 as_span 读取; 可写的 operator[] 与 push 会先就地 unpack,
+        // 只读的 operator[] 无法返回元素的引用, 直接抛出异常; JsonPath 不进入紧凑数组
+        using Int64Array = std::pmr::vector<IntNode>;
+        using DoubleArray = std::pmr::vector<FloatNode>;
+
+        // json中的所有值类型
+        using ValueType = std::variant<MonoNode, BoolNode, IntNode, FloatNode, StringNode, ArrayNode, ObjectNode, Int64Array, DoubleArray>;
+
+        // json节点定义
+        class Node {
+        protected:
+            ValueType value;
+        public:
+            // 构造函数
+            Node() : value(MonoNode{}) {}
+            explicit Node(const ValueType& _value) : value(_value) {}
+            explicit Node(ValueType&& _value) noexcept : value(std::move(_value)) {}
+
+            // 如果是json对象, 键不存在时插入 null
+            auto operator[](std::string_view key) -> Node& {
+                if (auto object = std::get_if<ObjectNode>(&value)) {
+                    return (*object)[key];
+                }
+                throw std::runtime_error("not an object");
+            }
+            // 用驻留池中的键查找时只比较指针
+            auto operator[](const Key& key) -> Node& {
+                if (auto object = std::get_if<ObjectNode>(&value)) {
+                    return (*object)[key];
+                }
+                throw std::runtime_error("not an object");
+            }
+            // 只读访问, 键不存在时抛出 std::out_of_range
+            auto operator[](std::string_view key) const -> const Node& {
+                if (auto object = std::get_if<ObjectNode>(&value)) {
+                    return object->at(key);
+                }
+                throw std::runtime_error("not an object");
+            }
+
+            // 如果是json数组, 返回元素的引用而不是拷贝; 紧凑数组先展开
+            auto operator[](size_t index) -> Node& {
+                unpack();
+                if (auto array = std::get_if<ArrayNode>(&value)) {
+                    return array->at(index);
+                }
+                throw std::runtime_error("not an array");
+            }
+            // 紧凑数组的元素没有 Node 可以引用, 用 as_span 读取
+            auto operator[](size_t index) const -> const Node& {
+                if (auto array = std::get_if<ArrayNode>(&value)) {
+                    return array->at(index);
+                }
+                throw std::runtime_error(is_packed() ? "packed array, read it with as_span" : "not an array");
+            }
+
+            // 查找成员, 不存在或不是对象时返回 nullptr
+            auto find(std::string_view key) -> Node* {
+                if (auto object = std::get_if<ObjectNode>(&value)) {
+                    if (auto it = object->find(key); it != object->end()) {
+                        return &it->second;
+                    }
+                }
+                return nullptr;
+            }
+            [[nodiscard]] auto find(std::string_view key) const -> const Node* {
+                return const_cast<Node*>(this)->find(key);
+            }
+            auto find(const Key& key) -> Node* {
+                if (auto object = std::get_if<ObjectNode>(&value)) {
+                    if (auto it = object->find(key); it != object->end()) {
+                        return &it->second;
+                    }
+                }
+                return nullptr;
+            }
+            [[nodiscard]] auto find(const Key& key) const -> const Node* {
+                return const_cast<Node*>(this)->find(key);
+            }
+            // 紧凑数组先展开再追加
+            void push(const Node& rhs) {
+                unpack();
+                if (auto array = std::get_if<ArrayNode>(&value)) {
+                    array->push_back(rhs);
+                }
+            }
+            void push(Node&& rhs) {
+                unpack();
+                if (auto array = std::get_if<ArrayNode>(&value)) {
+                    array->push_back(std::move(rhs));
+                }
+            }
+
+            [[nodiscard]] auto Value() const -> const ValueType& {
+                return value;
+            }
+            // 供就地构造使用, 例如解析器直接把子节点写进父容器
+            auto Value() -> ValueType& {
+                return value;
+            }
+
+            template<typename Ty>
+            [[nodiscard]] auto is() const -> bool {
+                return std::holds_alternative<Ty>(value);
+            }
+
+            // 紧凑数组的元素: IntNode 对应 Int64Array, FloatNode 对应 DoubleArray; 其他类型返回空
+            template<typename Ty>
+            [[nodiscard]] auto as_span() const -> std::optional<std::span<const Ty>> {
+                using Packed = std::conditional_t<std::is_same_v<Ty, IntNode>, Int64Array, DoubleArray>;
+                static_assert(std::is_same_v<Ty, IntNode> || std::is_same_v<Ty, FloatNode>, "only IntNode or FloatNode");
+                if (auto packed = std::get_if<Packed>(&value)) {
+                    return std::span<const Ty>{*packed};
+                }
+                return std::nullopt;
+            }
+            template<typename Ty>
+            auto as_span() -> std::optional<std::span<Ty>> {
+                using Packed = std::conditional_t<std::is_same_v<Ty, IntNode>, Int64Array, DoubleArray>;
+                static_assert(std::is_same_v<Ty, IntNode> || std::is_same_v<Ty, FloatNode>, "only IntNode or FloatNode");
+                if (auto packed = std::get_if<Packed>(&value)) {
+                    return std::span<Ty>{*packed};
+                }
+                return std::nullopt;
+            }
+            [[nodiscard]] auto is_packed() const -> bool {
+                return is<Int64Array>() || is<DoubleArray>();
+            }
+
+            // 把紧凑数组就地展开成 ArrayNode, 使用同一个 memory_resource; 其他类型不变
+            void unpack() {
+                const auto expand = [this](const auto& packed) {
+                    ArrayNode array{packed.get_allocator()};
+                    array.reserve(packed.size());
+                    for (const auto number : packed) {
+                        array.emplace_back(ValueType{number});
+                    }
+                    value.emplace<ArrayNode>(std::move(array));
+                };
+                if (auto ints = std::get_if<Int64Array>(&value)) {
+                    expand(*ints);
+                } else if (auto doubles = std::get_if<DoubleArray>(&value)) {
+                    expand(*doubles);
+                }
+            }
+
+            // 返回值的拷贝, 适合标量; 复合类型请用 get_if 或 as_ref 避免复制整棵子树
+            template<typename Ty>
+            [[nodiscard]] auto as() const -> std::optional<Ty> {
+                if (std::holds_alternative<Ty>(value)) {
+                    return std::get<Ty>(value);
+                }
+                return std::nullopt;
+            }
+
+            // 类型不符时返回 nullptr
+            template<typename Ty>
+            auto get_if() -> Ty* {
+                return std::get_if<Ty>(&value);
+            }
+            template<typename Ty>
+            [[nodiscard]] auto get_if() const -> const Ty* {
+                return std::get_if<Ty>(&value);
+            }
+
+            // 与 as 相同, 但返回引用
+            template<typename Ty>
+            auto as_ref() -> std::optional<std::reference_wrapper<Ty>> {
+                if (auto ptr = std::get_if<Ty>(&value)) {
+                    return std::ref(*ptr);
+                }
+                return std::nullopt;
+            }
+            template<typename Ty>
+            [[nodiscard]] auto as_ref() const -> std::optional<std::reference_wrapper<const Ty>> {
+                if (auto ptr = std::get_if<Ty>(&value)) {
+                    return std::cref(*ptr);
+                }
+                return std::nullopt;
+            }
+
+            static auto from_str(std::string_view json_str) -> std::optional<Node>;
+            static auto from_str(const char* data, size_t size) -> std::optional<Node>;
+            // 内存映射文件后直接解析, 不额外拷贝文件内容
+            static auto from_file(const std::filesystem::path& path) -> std::optional<Node>;
+
+            [[nodiscard]] auto to_str() const -> std::string;
+
+            friend auto operator<<(std::ostream& out, const Node& rhs) -> std::ostream&;
+        };
+
+        // 容器扩容时必须走移动而不是拷贝, 否则子树会被复制并丢掉原来的分配器
+        static_assert(std::is_nothrow_move_constructible_v<Node>);
+    }
+
+    namespace JsonIO {
+        // 只读的文件内容视图: 优先 mmap, 不支持映射时(管道、空文件、非 POSIX 平台)退回到 read() 读入内存
+        class MappedFile {
+        protected:
+            const char* data = nullptr;
+            size_t size = 0;
+            bool mapped = false;
+            std::string fallback;
+
+            MappedFile() = default;
+
+            void release() {
+#ifdef JSON_HAS_MMAP
+                if (mapped) {
+                    ::munmap(const_cast<char*>(data), size);
+                }
+#endif
+                data = nullptr;
+                size = 0;
+                mapped = false;
+                fallback.clear();
+            }
+        public:
+            MappedFile(const MappedFile&) = delete;
+            auto operator=(const MappedFile&) -> MappedFile& = delete;
+            MappedFile(MappedFile&& rhs) noexcept {
+                *this = std::move(rhs);
+            }
+            auto operator=(MappedFile&& rhs) noexcept -> MappedFile& {
+                if (this != &rhs) {
+                    release();
+                    mapped = std::exchange(rhs.mapped, false);
+                    size = std::exchange(rhs.size, 0);
+                    fallback = std::move(rhs.fallback);
+                    data = mapped ? std::exchange(rhs.data, nullptr) : fallback.data();
+                    rhs.data = nullptr;
+                }
+                return *this;
+            }
+            ~MappedFile() {
+                release();
+            }
+
+            static auto open(const std::filesystem::path& path) -> std::optional<MappedFile> {
+                MappedFile file;
+#ifdef JSON_HAS_MMAP
+                const int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    return {};
+                }
+                struct stat info{};
+                if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+                    const auto length = static_cast<size_t>(info.st_size);
+                    void* addr = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (addr != MAP_FAILED) {
+                        ::madvise(addr, length, MADV_SEQUENTIAL);
+                        ::close(fd);
+                        file.data = static_cast<const char*>(addr);
+                        file.size = length;
+                        file.mapped = true;
+                        return file;
+                    }
+                }
+                char chunk[65536];
+                while (true) {
+                    const auto count = ::read(fd, chunk, sizeof chunk);
+                    if (count < 0) {
+                        ::close(fd);
+                        return {};
+                    }
+                    if (count == 0) break;
+                    file.fallback.append(chunk, static_cast<size_t>(count));
+                }
+                ::close(fd);
+#else
+                std::ifstream in(path, std::ios::binary);
+                if (!in) {
+                    return {};
+                }
+                file.fallback.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+#endif
+                file.data = file.fallback.data();
+                file.size = file.fallback.size();
+                return file;
+            }
+
+            [[nodiscard]] auto view() const -> std::string_view {
+                return {data, size};
+            }
+            [[nodiscard]] auto is_mapped() const -> bool {
+                return mapped;
+            }
+        };
+    }
+
+    namespace JsonScan {
+        // json 只允许这四种空白字符, 不受 locale 影响
+        inline auto is_whitespace(char ch) -> bool {
+            return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
+        }
+
+        // 64 字节块的分类结果, 第 i 位对应块内第 i 个字节
+        struct BlockMasks {
+            uint64_t backslash = 0;
+            uint64_t quote = 0;
+            uint64_t op = 0;  // {}[]:,
+        };
+
+        // 标量实现, 同时用于处理向量化实现剩下的尾部
+        namespace Scalar {
+            inline void classify(const char* block, BlockMasks& masks) {
+                masks = {};
+                for (size_t i = 0; i < 64; ++i) {
+                    const auto bit = uint64_t{1} << i;
+                    switch (block[i]) {
+                        case '\\': masks.backslash |= bit; break;
+                        case '"': masks.quote |= bit; break;
+                        case '{': case '}': case '[': case ']': case ':': case ',': masks.op |= bit; break;
+                        default: break;
+                    }
+                }
+            }
+            inline auto skip_whitespace(const char* first, const char* last) -> const char* {
+                while (first < last && is_whitespace(*first)) {
+                    ++first;
+                }
+                return first;
+            }
+            inline auto find_quote_or_backslash(const char* first, const char* last) -> const char* {
+                while (first < last && *first != '"' && *first != '\\') {
+                    ++first;
+                }
+                return first;
+            }
+            inline auto find_escapable(const char* first, const char* last) -> const char* {
+                while (first < last && *first != '"' && *first != '\\' && static_cast<unsigned char>(*first) >= 0x20) {
+                    ++first;
+                }
+                return first;
+            }
+            inline auto find_escapable_ascii(const char* first, const char* last) -> const char* {
+                while (first < last && *first != '"' && *first != '\\' && static_cast<unsigned char>(*first) >= 0x20 &&
+                       static_cast<unsigned char>(*first) < 0x80) {
+                    ++first;
+                }
+                return first;
+            }
+            // 每次检查 8 个字节的最高位
+            inline auto skip_ascii(const char* first, const char* last) -> const char* {
+                for (; last - first >= 8; first += 8) {
+                    uint64_t word = 0;
+                    std::copy_n(first, sizeof word, reinterpret_cast<char*>(&word));
+                    if ((word & 0x8080808080808080ULL) != 0) {
+                        break;
+                    }
+                }
+                while (first < last && static_cast<unsigned char>(*first) < 0x80) {
+                    ++first;
+                }
+                return first;
+            }
+        }
+
+#ifdef JSON_HAS_SSE2
+        // 每次处理 16 字节
+        namespace Sse2 {
+            inline auto skip_whitespace(const char* first, const char* last) -> const char* {
+                const auto space = _mm_set1_epi8(' ');
+                const auto newline = _mm_set1_epi8('\n');
+                const auto ret = _mm_set1_epi8('\r');
+                const auto tab = _mm_set1_epi8('\t');
+                for (; last - first >= 16; first += 16) {
+                    const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                    const auto ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, newline)),
+                                                 _mm_or_si128(_mm_cmpeq_epi8(chunk, ret), _mm_cmpeq_epi8(chunk, tab)));
+                    const auto mask = static_cast<unsigned>(~_mm_movemask_epi8(ws)) & 0xffffu;
+                    if (mask != 0) {
+                        return first + std::countr_zero(mask);
+                    }
+                }
+                return Scalar::skip_whitespace(first, last);
+            }
+            inline auto find_quote_or_backslash(const char* first, const char* last) -> const char* {
+                const auto quote = _mm_set1_epi8('"');
+                const auto backslash = _mm_set1_epi8('\\');
+                for (; last - first >= 16; first += 16) {
+                    const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                    const auto hit = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+                    const auto mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+                    if (mask != 0) {
+                        return first + std::countr_zero(mask);
+                    }
+                }
+                return Scalar::find_quote_or_backslash(first, last);
+            }
+            // 控制字符用无符号比较: min(x, 0x1f) == x 即 x <= 0x1f
+            inline auto find_escapable(const char* first, const char* last) -> const char* {
+                const auto quote = _mm_set1_epi8('"');
+                const auto backslash = _mm_set1_epi8('\\');
+                const auto control = _mm_set1_epi8(0x1f);
+                for (; last - first >= 16; first += 16) {
+                    const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                    const auto hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                                  _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+                    const auto mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+                    if (mask != 0) {
+                        return first + std::countr_zero(mask);
+                    }
+                }
+                return Scalar::find_escapable(first, last);
+            }
+            // 非 ASCII 字节的最高位为 1, 直接并入 movemask
+            inline auto find_escapable_ascii(const char* first, const char* last) -> const char* {
+                const auto quote = _mm_set1_epi8('"');
+                const auto backslash = _mm_set1_epi8('\\');
+                const auto control = _mm_set1_epi8(0x1f);
+                for (; last - first >= 16; first += 16) {
+                    const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                    const auto hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                                  _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk), chunk));
+                    const auto mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+                    if (mask != 0) {
+                        return first + std::countr_zero(mask);
+                    }
+                }
+                return Scalar::find_escapable_ascii(first, last);
+            }
+            inline auto skip_ascii(const char* first, const char* last) -> const char* {
+                for (; last - first >= 16; first += 16) {
+                    const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                    const auto mask = static_cast<unsigned>(_mm_movemask_epi8(chunk));
+                    if (mask != 0) {
+                        return first + std::countr_zero(mask);
+                    }
+                }
+                return Scalar::skip_ascii(first, last);
+            }
+            inline void classify(const char* block, BlockMasks& masks) {
+                masks = {};
+                for (size_t i = 0; i < 64; i += 16) {
+                    const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+                    const auto eq = [&chunk](char ch) { return _mm_cmpeq_epi8(chunk, _mm_set1_epi8(ch)); };
+                    const auto op = _mm_or_si128(_mm_or_si128(_mm_or_si128(eq('{'), eq('}')), _mm_or_si128(eq('['), eq(']'))),
+                                                 _mm_or_si128(eq(':'), eq(',')));
+                    masks.backslash |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(eq('\\')))) << i;
+                    masks.quote |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(eq('"')))) << i;
+                    masks.op |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(op))) << i;
+                }
+            }
+        }
+#endif
+
+#ifdef JSON_HAS_AVX2
+        // 每次处理 32 字节, 仅在运行时检测到 AVX2 后使用
+        namespace Avx2 {
+            __attribute__((target("avx2")))
+            inline auto skip_whitespace(const char* first, const char* last) -> const char* {
+                const auto space = _mm256_set1_epi8(' ');
+                const auto newline = _mm256_set1_epi8('\n');
+                const auto ret = _mm256_set1_epi8('\r');
+                const auto tab = _mm256_set1_epi8('\t');
+                for (; last - first >= 32; first += 32) {
+                    const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+                    const auto ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, space), _mm256_cmpeq_epi8(chunk, newline)),
+                                                    _mm256_or_si256(_mm256_cmpeq_epi8(chunk, ret), _mm256_cmpeq_epi8(chunk, tab)));
+                    const auto mask = ~static_cast<unsigned>(_mm256_movemask_epi8(ws));
+                    if (mask != 0) {
+                        return first + std::countr_zero(mask);
+                    }
+                }
+                return Sse2::skip_whitespace(first, last);
+            }
+            __attribute__((target("avx2")))
+            inline auto find_quote_or_backslash(const char* first, const char* last) -> const char* {
+                const auto quote = _mm256_set1_epi8('"');
+                const auto backslash = _mm256_set1_epi8('\\');
+                for (; last - first >= 32; first += 32) {
+                    const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+                    const auto hit = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash));
+                    const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+                    if (mask != 0) {
+                        return first + std::countr_zero(mask);
+                    }
+                }
+                return Sse2::find_quote_or_backslash(first, last);
+            }
+            __attribute__((target("avx2")))
+            inline auto find_escapable(const char* first, const char* last) -> const char* {
+                const auto quote = _mm256_set1_epi8('"');
+                const auto backslash = _mm256_set1_epi8('\\');
+                const auto control = _mm256_set1_epi8(0x1f);
+                for (; last - first >= 32; first += 32) {
+                    const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+                    const auto hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+                                                     _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control), chunk));
+                    const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+                    if (mask != 0) {
+                        return first + std::countr_zero(mask);
+                    }
+                }
+                return Sse2::find_escapable(first, last);
+            }
+            __attribute__((target("avx2")))
+            inline auto find_escapable_ascii(const char* first, const char* last) -> const char* {
+                const auto quote = _mm256_set1_epi8('"');
+                const auto backslash = _mm256_set1_epi8('\\');
+                const auto control = _mm256_set1_epi8(0x1f);
+                for (; last - first >= 32; first += 32) {
+                    const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+                    const auto hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+                                                     _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control), chunk), chunk));
+                    const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+                    if (mask != 0) {
+                        return first + std::countr_zero(mask);
+                    }
+                }
+                return Sse2::find_escapable_ascii(first, last);
+            }
+            __attribute__((target("avx2")))
+            inline auto skip_ascii(const char* first, const char* last) -> const char* {
+                for (; last - first >= 32; first += 32) {
+                    const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+                    const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(chunk));
+                    if (mask != 0) {
+                        return first + std::countr_zero(mask);
+                    }
+                }
+                return Sse2::skip_ascii(first, last);
+            }
+            __attribute__((target("avx2")))
+            inline void classify(const char* block, BlockMasks& masks) {
+                masks = {};
+                for (size_t i = 0; i < 64; i += 32) {
+                    const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+                    const auto eq = [&chunk](char ch) __attribute__((target("avx2"))) {
+                        return _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(ch));
+                    };
+                    const auto op = _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(eq('{'), eq('}')), _mm256_or_si256(eq('['), eq(']'))),
+                                                    _mm256_or_si256(eq(':'), eq(',')));
+                    masks.backslash |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(eq('\\')))) << i;
+                    masks.quote |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(eq('"')))) << i;
+                    masks.op |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(op))) << i;
+                }
+            }
+        }
+#endif
+
+#ifdef JSON_HAS_NEON
+        // 每次处理 16 字节, 用 shrn 把比较结果压成 64 位掩码(每字节 4 位)
+        namespace Neon {
+            inline auto first_hit(uint8x16_t hit) -> uint64_t {
+                return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+            }
+            inline auto skip_whitespace(const char* first, const char* last) -> const char* {
+                for (; last - first >= 16; first += 16) {
+                    const auto chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(first));
+                    const auto ws = vorrq_u8(vorrq_u8(vceqq_u8(chunk, vdupq_n_u8(' ')), vceqq_u8(chunk, vdupq_n_u8('\n'))),
+                                             vorrq_u8(vceqq_u8(chunk, vdupq_n_u8('\r')), vceqq_u8(chunk, vdupq_n_u8('\t'))));
+                    const auto mask = first_hit(vmvnq_u8(ws));
+                    if (mask != 0) {
+                        return first + std::countr_zero(mask) / 4;
+                    }
+                }
+                return Scalar::skip_whitespace(first, last);
+            }
+            inline auto find_quote_or_backslash(const char* first, const char* last) -> const char* {
+                for (; last - first >= 16; first += 16) {
+                    const auto chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(first));
+                    const auto hit = vorrq_u8(vceqq_u8(chunk, vdupq_n_u8('"')), vceqq_u8(chunk, vdupq_n_u8('\\')));
+                    const auto mask = first_hit(hit);
+                    if (mask != 0) {
+                        return first + std::countr_zero(mask) / 4;
+                    }
+                }
+                return Scalar::find_quote_or_backslash(first, last);
+            }
+            inline auto find_escapable(const char* first, const char* last) -> const char* {
+                for (; last - first >= 16; first += 16) {
+                    const auto chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(first));
+                    const auto hit = vorrq_u8(vorrq_u8(vceqq_u8(chunk, vdupq_n_u8('"')), vceqq_u8(chunk, vdupq_n_u8('\\'))),
+                                              vcltq_u8(chunk, vdupq_n_u8(0x20)));
+                    const auto mask = first_hit(hit);
+                    if (mask != 0) {
+                        return first + std::countr_zero(mask) / 4;
+                    }
+                }
+                return Scalar::find_escapable(first, last);
+            }
+            inline auto find_escapable_ascii(const char* first, const char* last) -> const char* {
+                for (; last - first >= 16; first += 16) {
+                    const auto chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(first));
+                    const auto hit = vorrq_u8(vorrq_u8(vceqq_u8(chunk, vdupq_n_u8('"')), vceqq_u8(chunk, vdupq_n_u8('\\'))),
+                                              vorrq_u8(vcltq_u8(chunk, vdupq_n_u8(0x20)), vcgeq_u8(chunk, vdupq_n_u8(0x80))));
+                    const auto mask = first_hit(hit);
+                    if (mask != 0) {
+                        return first + std::countr_zero(mask) / 4;
+                    }
+                }
+                return Scalar::find_escapable_ascii(first, last);
+            }
+            inline auto skip_ascii(const char* first, const char* last) -> const char* {
+                for (; last - first >= 16; first += 16) {
+                    const auto mask = first_hit(vcgeq_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(first)), vdupq_n_u8(0x80)));
+                    if (mask != 0) {
+                        return first + std::countr_zero(mask) / 4;
+                    }
+                }
+                return Scalar::skip_ascii(first, last);
+            }
+            // 把 4 个比较结果压成 64 位掩码
+            inline auto to_bitmask(uint8x16_t v0, uint8x16_t v1, uint8x16_t v2, uint8x16_t v3) -> uint64_t {
+                const uint8x16_t bits = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+                                         0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+                auto sum0 = vpaddq_u8(vandq_u8(v0, bits), vandq_u8(v1, bits));
+                const auto sum1 = vpaddq_u8(vandq_u8(v2, bits), vandq_u8(v3, bits));
+                sum0 = vpaddq_u8(sum0, sum1);
+                sum0 = vpaddq_u8(sum0, sum0);
+                return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+            }
+            inline void classify(const char* block, BlockMasks& masks) {
+                uint8x16_t chunk[4];
+                for (size_t i = 0; i < 4; ++i) {
+                    chunk[i] = vld1q_u8(reinterpret_cast<const uint8_t*>(block + i * 16));
+                }
+                const auto eq = [&chunk](size_t i, char ch) { return vceqq_u8(chunk[i], vdupq_n_u8(static_cast<uint8_t>(ch))); };
+                const auto op = [&eq](size_t i) {
+                    return vorrq_u8(vorrq_u8(vorrq_u8(eq(i, '{'), eq(i, '}')), vorrq_u8(eq(i, '['), eq(i, ']'))),
+                                    vorrq_u8(eq(i, ':'), eq(i, ',')));
+                };
+                masks.backslash = to_bitmask(eq(0, '\\'), eq(1, '\\'), eq(2, '\\'), eq(3, '\\'));
+                masks.quote = to_bitmask(eq(0, '"'), eq(1, '"'), eq(2, '"'), eq(3, '"'));
+                masks.op = to_bitmask(op(0), op(1), op(2), op(3));
+            }
+        }
+#endif
+
+        // 运行时选定的一组扫描函数
+        struct Kernels {
+            const char* name;
+            auto (*skip_whitespace)(const char*, const char*) -> const char*;
+            auto (*find_quote_or_backslash)(const char*, const char*) -> const char*;
+            void (*classify)(const char*, BlockMasks&);
+            auto (*find_escapable)(const char*, const char*) -> const char*;
+            auto (*find_escapable_ascii)(const char*, const char*) -> const char*;
+            auto (*skip_ascii)(const char*, const char*) -> const char*;
+        };
+
+        inline auto select_kernels() -> Kernels {
+#ifdef JSON_HAS_AVX2
+            if (__builtin_cpu_supports("avx2")) {
+                return {"avx2", Avx2::skip_whitespace, Avx2::find_quote_or_backslash, Avx2::classify, Avx2::find_escapable, Avx2::find_escapable_ascii, Avx2::skip_ascii};
+            }
+#endif
+#if defined(JSON_HAS_SSE2)
+            return {"sse2", Sse2::skip_whitespace, Sse2::find_quote_or_backslash, Sse2::classify, Sse2::find_escapable, Sse2::find_escapable_ascii, Sse2::skip_ascii};
+#elif defined(JSON_HAS_NEON)
+            return {"neon", Neon::skip_whitespace, Neon::find_quote_or_backslash, Neon::classify, Neon::find_escapable, Neon::find_escapable_ascii, Neon::skip_ascii};
+#else
+            return {"scalar", Scalar::skip_whitespace, Scalar::find_quote_or_backslash, Scalar::classify, Scalar::find_escapable, Scalar::find_escapable_ascii, Scalar::skip_ascii};
+#endif
+        }
+
+        inline auto kernels() -> const Kernels& {
+            static const Kernels active = select_kernels();
+            return active;
+        }
+
+        // 跳过空白; 紧凑格式下通常一个空白都没有, 先用标量判断避免进入向量循环
+        inline auto skip_whitespace(const char* first, const char* last) -> const char* {
+            if (first == last || !is_whitespace(*first)) {
+                return first;
+            }
+            if (last - first < 16 || !is_whitespace(first[1])) {
+                return Scalar::skip_whitespace(first + 1, last);
+            }
+            return kernels().skip_whitespace(first + 2, last);
+        }
+
+        // 返回第一个 `"` 或 `\` 的位置, 没有则返回 last
+        inline auto find_quote_or_backslash(const char* first, const char* last) -> const char* {
+            return kernels().find_quote_or_backslash(first, last);
+        }
+
+        // 返回第一个输出时需要转义的字节(`"`、`\` 与控制字符)的位置, 没有则返回 last
+        inline auto find_escapable(const char* first, const char* last) -> const char* {
+            return kernels().find_escapable(first, last);
+        }
+        // 同上, 另外在第一个非 ASCII 字节处停下
+        inline auto find_escapable_ascii(const char* first, const char* last) -> const char* {
+            return kernels().find_escapable_ascii(first, last);
+        }
+
+        // 返回第一个非 ASCII 字节的位置, 没有则返回 last
+        inline auto skip_ascii(const char* first, const char* last) -> const char* {
+            return kernels().skip_ascii(first, last);
+        }
+
+        // 返回第一个不合法的 UTF-8 序列的位置(过长编码、代理项、超过 U+10FFFF 与截断都不合法), 全部合法时返回 last
+        // ASCII 段由向量化的 skip_ascii 跳过, 只有多字节序列逐个检查
+        inline auto validate_utf8(const char* first, const char* last) -> const char* {
+            const auto byte = [](const char* ptr) { return static_cast<unsigned char>(*ptr); };
+            while (true) {
+                first = skip_ascii(first, last);
+                if (first == last) {
+                    return last;
+                }
+                const auto lead = byte(first);
+                size_t length = 0;
+                unsigned char low = 0x80, high = 0xbf;  // 第二个字节的范围
+                if (lead >= 0xc2 && lead <= 0xdf) {
+                    length = 2;
+                } else if (lead >= 0xe0 && lead <= 0xef) {
+                    length = 3;
+                    if (lead == 0xe0) low = 0xa0;
+                    if (lead == 0xed) high = 0x9f;
+                } else if (lead >= 0xf0 && lead <= 0xf4) {
+                    length = 4;
+                    if (lead == 0xf0) low = 0x90;
+                    if (lead == 0xf4) high = 0x8f;
+                } else {
+                    return first;
+                }
+                if (static_cast<size_t>(last - first) < length || byte(first + 1) < low || byte(first + 1) > high) {
+                    return first;
+                }
+                for (size_t i = 2; i < length; ++i) {
+                    if ((byte(first + i) & 0xc0) != 0x80) {
+                        return first;
+                    }
+                }
+                first += length;
+            }
+        }
+
+        inline auto is_digit(char ch) -> bool {
+            return static_cast<unsigned char>(ch - '0') < 10;
+        }
+
+        // 数字的扫描结果, end 为 nullptr 表示不是合法的 json 数字
+        struct Number {
+            const char* end = nullptr;
+            bool is_float = false;
+            int64_t integer = 0;
+            double floating = 0;
+        };
+
+        // 按 json 文法 -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)? 找到数字的结尾, 不合法时返回 nullptr
+        inline auto skip_number(const char* first, const char* last, bool& is_float) -> const char* {
+            auto cursor = first;
+            is_float = false;
+            if (cursor < last && *cursor == '-') ++cursor;
+            if (cursor == last || !is_digit(*cursor)) {
+                return nullptr;
+            }
+            if (*cursor == '0') {
+                ++cursor;
+            } else {
+                while (cursor < last && is_digit(*cursor)) ++cursor;
+            }
+            if (cursor < last && *cursor == '.') {
+                is_float = true;
+                if (++cursor == last || !is_digit(*cursor)) {
+                    return nullptr;
+                }
+                while (cursor < last && is_digit(*cursor)) ++cursor;
+            }
+            if (cursor < last && (*cursor == 'e' || *cursor == 'E')) {
+                is_float = true;
+                ++cursor;
+                if (cursor < last && (*cursor == '+' || *cursor == '-')) ++cursor;
+                if (cursor == last || !is_digit(*cursor)) {
+                    return nullptr;
+                }
+                while (cursor < last && is_digit(*cursor)) ++cursor;
+            }
+            return cursor;
+        }
+
+        // 合法数字 [first, last) 首个非零数字的十进制数量级(科学计数法中的指数), 指数部分过长时饱和
+        // 只用来区分超出范围的数是上溢还是下溢; 全为零时返回 0
+        inline auto decimal_order(const char* first, const char* last) -> int64_t {
+            constexpr int64_t saturation = int64_t{1} << 40;
+            auto cursor = first + (*first == '-');
+            int64_t order = 0;
+            bool found = false;  // 已经遇到非零数字
+            for (; cursor < last && is_digit(*cursor); ++cursor) {
+                if (found) {
+                    order = std::min(order + 1, saturation);
+                } else if (*cursor != '0') {
+                    found = true;
+                }
+            }
+            if (cursor < last && *cursor == '.') {
+                for (++cursor; cursor < last && is_digit(*cursor); ++cursor) {
+                    if (found) continue;
+                    order = std::max(order - 1, -saturation);
+                    found = *cursor != '0';
+                }
+            }
+            if (!found) {
+                return 0;
+            }
+            if (cursor < last && (*cursor == 'e' || *cursor == 'E')) {
+                ++cursor;
+                const bool negative = *cursor == '-';
+                cursor += *cursor == '-' || *cursor == '+';
+                int64_t exponent = 0;
+                for (; cursor < last && is_digit(*cursor); ++cursor) {
+                    exponent = std::min(exponent * 10 + (*cursor - '0'), saturation);
+                }
+                order += negative ? -exponent : exponent;
+            }
+            return order;
+        }
+
+        // 扫描数字并就地转换, 不分配也不抛异常; 超出 int64 范围的整数退化为 double
+        inline auto scan_number(const char* first, const char* last) -> Number {
+            Number number;
+            const auto cursor = skip_number(first, last, number.is_float);
+            if (cursor == nullptr) {
+                return number;
+            }
+
+            if (!number.is_float) {
+                const auto [end, error] = std::from_chars(first, cursor, number.integer);
+                if (error == std::errc{}) {
+                    number.end = end;
+                    return number;
+                }
+                number.is_float = true;
+            }
+            const auto [end, error] = std::from_chars(first, cursor, number.floating);
+            if (error == std::errc{}) {
+                number.end = end;
+            } else if (error == std::errc::result_out_of_range) {
+                // 文法合法但超出 double 范围: 与 strtod 一致, 上溢为 ±HUGE_VAL(序列化时写成 null), 下溢为同号的零
+                // from_chars 不写出结果, 由十进制数量级判断方向; 非正规数在范围之内, 不会走到这里
+                number.floating = std::copysign(decimal_order(first, cursor) >= 0 ? HUGE_VAL : 0.0, *first == '-' ? -1.0 : 1.0);
+                number.end = end;
+            }
+            return number;
+        }
+
+        // first 指向开头引号之后, 返回结尾引号的位置; 转义字符被整体跳过, 字符串未结束时返回 nullptr
+        // escaped 记录其中是否出现过转义, 没有转义的字符串可以直接引用输入
+        inline auto scan_string(const char* first, const char* last, bool& escaped) -> const char* {
+            escaped = false;
+            while (true) {
+                first = find_quote_or_backslash(first, last);
+                if (first == last) {
+                    return nullptr;
+                }
+                if (*first == '"') {
+                    return first;
+                }
+                escaped = true;
+                first += 2;  // 跳过转义字符, 避免把 `\"` 当成结尾
+                if (first > last) {
+                    return nullptr;
+                }
+            }
+        }
+        inline auto scan_string(const char* first, const char* last) -> const char* {
+            bool escaped = false;
+            return scan_string(first, last, escaped);
+        }
+
+        inline auto parse_hex4(const char* first, uint32_t& value) -> bool {
+            value = 0;
+            for (size_t i = 0; i < 4; ++i) {
+                const auto ch = first[i];
+                uint32_t digit = 0;
+                if (is_digit(ch)) {
+                    digit = static_cast<uint32_t>(ch - '0');
+                } else if (ch >= 'a' && ch <= 'f') {
+                    digit = static_cast<uint32_t>(ch - 'a' + 10);
+                } else if (ch >= 'A' && ch <= 'F') {
+                    digit = static_cast<uint32_t>(ch - 'A' + 10);
+                } else {
+                    return false;
+                }
+                value = value << 4 | digit;
+            }
+            return true;
+        }
+
+        template<typename String>
+        void append_utf8(String& out, uint32_t code_point) {
+            if (code_point < 0x80) {
+                out.push_back(static_cast<char>(code_point));
+            } else if (code_point < 0x800) {
+                out.push_back(static_cast<char>(0xc0 | code_point >> 6));
+                out.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+            } else if (code_point < 0x10000) {
+                out.push_back(static_cast<char>(0xe0 | code_point >> 12));
+                out.push_back(static_cast<char>(0x80 | (code_point >> 6 & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+            } else {
+                out.push_back(static_cast<char>(0xf0 | code_point >> 18));
+                out.push_back(static_cast<char>(0x80 | (code_point >> 12 & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (code_point >> 6 & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+            }
+        }
+
+        // 把引号之间的原始内容解码后追加到 out; `\uXXXX` 按 UTF-8 输出, 代理对合并为一个码点
+        // 未知的转义、不完整的 `\u` 与落单的代理项返回 false
+        template<typename String>
+        auto unescape(std::string_view raw, String& out) -> bool {
+            auto first = raw.data();
+            const auto last = first + raw.size();
+            while (true) {
+                const auto hit = std::find(first, last, '\\');
+                out.append(first, hit);
+                if (hit == last) {
+                    return true;
+                }
+                if (last - hit < 2) {
+                    return false;
+                }
+                first = hit + 2;
+                switch (hit[1]) {
+                    case '"': out.push_back('"'); break;
+                    case '\\': out.push_back('\\'); break;
+                    case '/': out.push_back('/'); break;
+                    case 'b': out.push_back('\b'); break;
+                    case 'f': out.push_back('\f'); break;
+                    case 'n': out.push_back('\n'); break;
+                    case 'r': out.push_back('\r'); break;
+                    case 't': out.push_back('\t'); break;
+                    case 'u': {
+                        uint32_t code_point = 0;
+                        if (last - first < 4 || !parse_hex4(first, code_point)) {
+                            return false;
+                        }
+                        first += 4;
+                        if (code_point >= 0xdc00 && code_point <= 0xdfff) {
+                            return false;
+                        }
+                        if (code_point >= 0xd800 && code_point <= 0xdbff) {
+                            uint32_t low = 0;
+                            if (last - first < 6 || first[0] != '\\' || first[1] != 'u' || !parse_hex4(first + 2, low) ||
+                                low < 0xdc00 || low > 0xdfff) {
+                                return false;
+                            }
+                            first += 6;
+                            code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low - 0xdc00);
+                        }
+                        append_utf8(out, code_point);
+                        break;
+                    }
+                    default:
+                        return false;
+                }
+            }
+        }
+
+        // 字符串的解码结果: 没有转义时直接引用输入, 否则解码到 scratch 中; 转义不合法时返回空
+        inline auto decode_string(std::string_view raw, bool escaped, std::string& scratch) -> std::optional<std::string_view> {
+            if (!escaped) {
+                return raw;
+            }
+            scratch.clear();
+            if (!unescape(raw, scratch)) {
+                return {};
+            }
+            return std::string_view{scratch};
+        }
+
+        inline auto skip_literal(const char* first, const char* last, std::string_view literal) -> const char* {
+            if (static_cast<size_t>(last - first) >= literal.size() && std::string_view{first, literal.size()} == literal) {
+                return first + literal.size();
+            }
+            return nullptr;
+        }
+
+        // 跳过 first 处完整的一个值并返回其后位置, 不分配也不递归; 输入不完整时返回 nullptr
+        // 只检查括号层数, 不校验容器内部的文法
+        inline auto skip_value(const char* first, const char* last) -> const char* {
+            if (first == last) {
+                return nullptr;
+            }
+            switch (*first) {
+                case '"': {
+                    const auto end = scan_string(first + 1, last);
+                    return end ? end + 1 : nullptr;
+                }
+                case 't':
+                    return skip_literal(first, last, "true");
+                case 'f':
+                    return skip_literal(first, last, "false");
+                case 'n':
+                    return skip_literal(first, last, "null");
+                case '[':
+                case '{': {
+                    size_t depth = 0;
+                    for (auto cursor = first; cursor < last; ++cursor) {
+                        switch (*cursor) {
+                            case '"':
+                                cursor = scan_string(cursor + 1, last);
+                                if (cursor == nullptr) {
+                                    return nullptr;
+                                }
+                                break;
+                            case '[':
+                            case '{':
+                                ++depth;
+                                break;
+                            case ']':
+                            case '}':
+                                if (--depth == 0) {
+                                    return cursor + 1;
+                                }
+                                break;
+                            default:
+                                break;
+                        }
+                    }
+                    return nullptr;
+                }
+                default: {
+                    bool is_float = false;
+                    return skip_number(first, last, is_float);
+                }
+            }
+        }
+
+        // 标出被奇数个连续反斜杠转义的字节; carry 记录上一块是否以奇数个反斜杠结尾
+        inline auto find_escaped(uint64_t backslash, uint64_t& carry) -> uint64_t {
+            constexpr uint64_t even_bits = 0x5555555555555555ULL;
+            constexpr uint64_t odd_bits = ~even_bits;
+            const auto start_edges = backslash & ~(backslash << 1);
+            const auto even_start_mask = even_bits ^ carry;
+            const auto even_starts = start_edges & even_start_mask;
+            const auto odd_starts = start_edges & ~even_start_mask;
+            const auto even_carries = backslash + even_starts;
+            auto odd_carries = backslash + odd_starts;
+            const bool ends_odd = odd_carries < backslash;  // 加法溢出: 反斜杠序列延续到下一块
+            odd_carries |= carry;
+            carry = ends_odd ? 1 : 0;
+            const auto even_carry_ends = even_carries & ~backslash;
+            const auto odd_carry_ends = odd_carries & ~backslash;
+            return (even_carry_ends & odd_bits) | (odd_carry_ends & even_bits);
+        }
+
+        // 前缀异或: 第 i 位为第 0..i 位的异或, 用来把引号位置变成字符串区间
+        inline auto prefix_xor(uint64_t bits) -> uint64_t {
+            bits ^= bits << 1;
+            bits ^= bits << 2;
+            bits ^= bits << 4;
+            bits ^= bits << 8;
+            bits ^= bits << 16;
+            bits ^= bits << 32;
+            return bits;
+        }
+
+        // 结构字符索引: 字符串之外的 {}[]:, 以及未转义的引号在输入中的位置, 每次处理 64 字节
+        // 输入超过 4GB 或字符串没有结束时返回 false
+        inline auto build_structural_index(std::string_view text, std::vector<uint32_t>& index) -> bool {
+            index.clear();
+            if (text.size() > UINT32_MAX) {
+                return false;
+            }
+            index.reserve(text.size() / 8);
+            const auto classify = kernels().classify;
+            uint64_t escape_carry = 0;
+            uint64_t in_string_carry = 0;
+            char tail[64];
+            for (size_t offset = 0; offset < text.size(); offset += 64) {
+                auto block = text.data() + offset;
+                if (text.size() - offset < 64) {
+                    std::fill(std::begin(tail), std::end(tail), ' ');
+                    std::copy(block, text.data() + text.size(), tail);
+                    block = tail;
+                }
+                BlockMasks masks;
+                classify(block, masks);
+                const auto quotes = masks.quote & ~find_escaped(masks.backslash, escape_carry);
+                const auto in_string = prefix_xor(quotes) ^ in_string_carry;
+                in_string_carry = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+                auto structurals = (masks.op & ~in_string) | quotes;
+                while (structurals != 0) {
+                    index.push_back(static_cast<uint32_t>(offset + static_cast<size_t>(std::countr_zero(structurals))));
+                    structurals &= structurals - 1;
+                }
+            }
+            return in_string_carry == 0;
+        }
+    }
+
+    namespace JsonParser {
+        using JsonNode::Node;
+        using JsonNode::ArrayNode, JsonNode::ObjectNode;
+        using JsonNode::MonoNode, JsonNode::ValueType, JsonNode::BoolNode, JsonNode::IntNode, JsonNode::FloatNode, JsonNode::StringNode;
+
+        // 各类值的个数, 对象的键单独计数
+        struct ValueCounts {
+            size_t nulls = 0;
+            size_t bools = 0;
+            size_t integers = 0;
+            size_t floats = 0;
+            size_t strings = 0;
+            size_t keys = 0;
+            size_t arrays = 0;
+            size_t objects = 0;
+
+            auto operator+=(const ValueCounts& rhs) -> ValueCounts& {
+                nulls += rhs.nulls;
+                bools += rhs.bools;
+                integers += rhs.integers;
+                floats += rhs.floats;
+                strings += rhs.strings;
+                keys += rhs.keys;
+                arrays += rhs.arrays;
+                objects += rhs.objects;
+                return *this;
+            }
+        };
+
+        // 解析统计, 在多次解析之间累加; 每个线程各用一份, 汇总时相加
+        // 只想了解负载的形状时, 用 NullHandler 做一遍 parse_sax 即可, 不需要构造树
+        struct ParseStats : ValueCounts {
+            size_t documents = 0;
+            size_t bytes = 0;             // 消耗的输入字节数
+            size_t string_bytes = 0;      // 字符串与键在输入中的字节数, 含引号与转义
+            size_t structural_bytes = 0;  // {}[]:, 的个数
+            size_t max_depth = 0;
+            // 只有 Parser 在 arena 或 JsonMemory::CountingResource 上解析时才能统计
+            size_t allocations = 0;
+            size_t allocated_bytes = 0;
+            // 只在定义 JSON_PARSE_TIMING 时累计, 单位为纳秒; 容器的时间包含其中所有子节点
+            uint64_t string_ns = 0;
+            uint64_t number_ns = 0;
+            uint64_t object_ns = 0;
+            uint64_t array_ns = 0;
+
+            auto operator+=(const ParseStats& rhs) -> ParseStats& {
+                ValueCounts::operator+=(rhs);
+                documents += rhs.documents;
+                bytes += rhs.bytes;
+                string_bytes += rhs.string_bytes;
+                structural_bytes += rhs.structural_bytes;
+                max_depth = std::max(max_depth, rhs.max_depth);
+                allocations += rhs.allocations;
+                allocated_bytes += rhs.allocated_bytes;
+                string_ns += rhs.string_ns;
+                number_ns += rhs.number_ns;
+                object_ns += rhs.object_ns;
+                array_ns += rhs.array_ns;
+                return *this;
+            }
+        };
+
+        // 解析器在 arena 之外直接向堆申请的内存: 解码缓冲区与各个栈的扩容
+        struct HeapStats {
+            size_t allocations = 0;
+            size_t bytes = 0;
+
+            // 缓冲区的容量只会因为重新分配而改变
+            void record(size_t old_capacity, size_t new_capacity, size_t element_size) {
+                if (new_capacity != old_capacity) {
+                    ++allocations;
+                    bytes += new_capacity * element_size;
+                }
+            }
+            auto operator+=(const HeapStats& rhs) -> HeapStats& {
+                allocations += rhs.allocations;
+                bytes += rhs.bytes;
+                return *this;
+            }
+        };
+
+        // 可复用解析器的内存统计: arena 的计数之外, 还有解析器自身缓冲区的扩容
+        struct MemoryStats : JsonMemory::ArenaStats {
+            size_t heap_allocations = 0;
+            size_t heap_bytes = 0;
+        };
+
+        // SAX 事件接收者; 每个回调返回 false 时立即停止解析
+        // string_view 参数是解码转义后的内容, 只在回调期间有效
+        template<typename Handler>
+        concept SaxHandler = requires(Handler& handler, bool b, IntNode i, FloatNode d, std::string_view str) {
+            { handler.on_null() } -> std::convertible_to<bool>;
+            { handler.on_bool(b) } -> std::convertible_to<bool>;
+            { handler.on_int(i) } -> std::convertible_to<bool>;
+            { handler.on_double(d) } -> std::convertible_to<bool>;
+            { handler.on_string(str) } -> std::convertible_to<bool>;
+            { handler.start_object() } -> std::convertible_to<bool>;
+            { handler.key(str) } -> std::convertible_to<bool>;
+            { handler.end_object() } -> std::convertible_to<bool>;
+            { handler.start_array() } -> std::convertible_to<bool>;
+            { handler.end_array() } -> std::convertible_to<bool>;
+        };
+
+        // 所有事件都忽略的默认实现, 继承后只需要覆盖关心的回调(静态分派, 不是虚函数)
+        struct NullHandler {
+            auto on_null() -> bool { return true; }
+            auto on_bool(BoolNode) -> bool { return true; }
+            auto on_int(IntNode) -> bool { return true; }
+            auto on_double(FloatNode) -> bool { return true; }
+            auto on_string(std::string_view) -> bool { return true; }
+            auto start_object() -> bool { return true; }
+            auto key(std::string_view) -> bool { return true; }
+            auto end_object() -> bool { return true; }
+            auto start_array() -> bool { return true; }
+            auto end_array() -> bool { return true; }
+        };
+
+        // 默认允许的最大嵌套层数
+        inline constexpr size_t default_max_depth = 1024;
+
+        // 尚未结束的容器, 每层一位(1 为对象); 默认深度以内不分配内存
+        class ContainerStack {
+        protected:
+            static constexpr size_t inline_depth = default_max_depth;
+
+            uint64_t inline_bits[inline_depth / 64]{};
+            std::vector<uint64_t> heap_bits;  // 超过 inline_depth 后整体搬到这里
+            size_t depth = 0;
+            HeapStats heap;
+
+            auto bits() -> uint64_t* { return heap_bits.empty() ? inline_bits : heap_bits.data(); }
+            [[nodiscard]] auto bits() const -> const uint64_t* { return heap_bits.empty() ? inline_bits : heap_bits.data(); }
+        public:
+            void push(bool is_object) {
+                if (depth == inline_depth && heap_bits.empty()) {
+                    const auto capacity = heap_bits.capacity();
+                    heap_bits.assign(std::begin(inline_bits), std::end(inline_bits));
+                    heap.record(capacity, heap_bits.capacity(), sizeof(uint64_t));
+                }
+                if (!heap_bits.empty() && depth / 64 == heap_bits.size()) {
+                    const auto capacity = heap_bits.capacity();
+                    heap_bits.push_back(0);
+                    heap.record(capacity, heap_bits.capacity(), sizeof(uint64_t));
+                }
+                auto& word = bits()[depth / 64];
+                const auto bit = uint64_t{1} << (depth % 64);
+                word = is_object ? word | bit : word & ~bit;
+                ++depth;
+            }
+            void pop() { --depth; }
+            [[nodiscard]] auto top() const -> bool { return (bits()[(depth - 1) / 64] >> ((depth - 1) % 64) & 1) != 0; }
+            [[nodiscard]] auto size() const -> size_t { return depth; }
+            [[nodiscard]] auto empty() const -> bool { return depth == 0; }
+            void clear() { depth = 0; }
+            [[nodiscard]] auto heap_stats() const -> const HeapStats& { return heap; }
+        };
+
+        // 直接由词法分析驱动 handler 的解析器, handler 是模板参数, 回调可以被完全内联
+        // 各个解析入口接受的文法以这里为准:
+        // - 默认是宽松模式: 逗号与冒号可以省略, 容器末尾可以多一个逗号, 解析完一个值后停下, 其后的内容不检查;
+        //   Node::from_str、Parser 与 Tape::parse 都按宽松模式解析, JsonParallel 接受的输入与之完全相同
+        // - set_strict(true) 后按 RFC 8259 的结构规则: 逗号与冒号必需, 不允许尾随逗号, 值之后只能是空白,
+        //   与 validate() 以及 JsonStream 的增量解析器一致(字符串中的 UTF-8 不检查, 需要时先 validate)
+        template<SaxHandler Handler>
+        class SaxParser {
+        protected:
+            std::string_view json_str;
+            size_t pos = 0;
+            size_t max_depth;
+            bool strict = false;
+            ContainerStack stack;
+            Handler& handler;
+            // 含转义的字符串解码到 scratch; 调用者没有提供缓冲区时指向 local_scratch, 容量只在这个文档中复用
+            std::string local_scratch;
+            std::string& scratch;
+            HeapStats scratch_heap;
+            ParseStats* stats;    // 为空时不统计
+
+            void count(size_t ParseStats::* field, size_t amount = 1) {
+                if (stats) stats->*field += amount;
+            }
+
+#ifdef JSON_PARSE_TIMING
+            using Clock = std::chrono::steady_clock;
+            // 析构时把经过的时间累加到 stats 的对应字段
+            struct PhaseTimer {
+                ParseStats* stats;
+                uint64_t ParseStats::* field;
+                Clock::time_point start = Clock::now();
+                ~PhaseTimer() {
+                    if (stats) stats->*field += static_cast<uint64_t>(std::chrono::nanoseconds{Clock::now() - start}.count());
+                }
+            };
+            std::vector<Clock::time_point> open_times;  // 尚未结束的容器的开始时间
+
+            [[nodiscard]] auto time_phase(uint64_t ParseStats::* field) const -> PhaseTimer { return {stats, field}; }
+            void time_open() {
+                if (stats) open_times.push_back(Clock::now());
+            }
+            void time_close(bool is_object) {
+                if (!stats) return;
+                const auto elapsed = std::chrono::nanoseconds{Clock::now() - open_times.back()}.count();
+                open_times.pop_back();
+                (is_object ? stats->object_ns : stats->array_ns) += static_cast<uint64_t>(elapsed);
+            }
+#else
+            // 未启用计时时是空操作, 整体被优化掉
+            struct PhaseTimer {};
+            [[nodiscard]] auto time_phase(uint64_t ParseStats::*) const -> PhaseTimer { return {}; }
+            void time_open() {}
+            void time_close(bool) {}
+#endif
+
+            void skip_whitespace() {
+                const auto begin = json_str.data();
+                pos = static_cast<size_t>(JsonScan::skip_whitespace(begin + pos, begin + json_str.size()) - begin);
+            }
+
+            auto parse_literal(std::string_view literal, size_t ParseStats::* field) -> bool {
+                if (json_str.substr(pos, literal.size()) == literal) {
+                    pos += literal.size();
+                    count(field);
+                    return true;
+                }
+                return false;
+            }
+
+            auto parse_number() -> bool {
+                [[maybe_unused]] const auto timer = time_phase(&ParseStats::number_ns);
+                const auto begin = json_str.data();
+                const auto number = JsonScan::scan_number(begin + pos, begin + json_str.size());
+                if (number.end == nullptr) {
+                    return false;
+                }
+                pos = static_cast<size_t>(number.end - begin);
+                count(number.is_float ? &ParseStats::floats : &ParseStats::integers);
+                return number.is_float ? handler.on_double(number.floating) : handler.on_int(number.integer);
+            }
+
+            // 扫描字符串并返回解码后的内容: 没有转义时直接引用输入, 否则解码到 scratch 中
+            auto scan_string() -> std::optional<std::string_view> {
+                [[maybe_unused]] const auto timer = time_phase(&ParseStats::string_ns);
+                const auto begin = json_str.data();
+                const auto start_pos = pos;
+                bool escaped = false;
+                const auto cursor = JsonScan::scan_string(begin + ++pos, begin + json_str.size(), escaped);  // 去掉 `"`
+                if (cursor == nullptr) {
+                    return {};  // 字符串没有结束
+                }
+
+                const auto end_pos = static_cast<size_t>(cursor - begin);
+                const auto string_str = json_str.substr(pos, end_pos - pos);
+                pos = end_pos + 1;   // 去掉 `"`
+                count(&ParseStats::string_bytes, pos - start_pos);
+                if (escaped) {
+                    // 解码后不会比原文长, 一次预留到位, 每次扩容都能被记录
+                    const auto capacity = scratch.capacity();
+                    scratch.reserve(string_str.size());
+                    scratch_heap.record(capacity, scratch.capacity(), 1);
+                }
+                return JsonScan::decode_string(string_str, escaped, scratch);
+            }
+
+            auto parse_string() -> bool {
+                const auto string_str = scan_string();
+                count(&ParseStats::strings);
+                return string_str && handler.on_string(*string_str);
+            }
+
+            // 解析一个标量值
+            auto parse_scalar() -> bool {
+                switch (json_str[pos]) {
+                    case 'n':
+                        return parse_literal("null", &ParseStats::nulls) && handler.on_null();
+                    case 't':
+                        return parse_literal("true", &ParseStats::bools) && handler.on_bool(true);
+                    case 'f':
+                        return parse_literal("false", &ParseStats::bools) && handler.on_bool(false);
+                    case '"':
+                        return parse_string();
+                    default:
+                        return parse_number();
+                }
+            }
+
+            auto open(bool is_object) -> bool {
+                if (stack.size() >= max_depth) {
+                    return false;  // 嵌套过深, 立即失败
+                }
+                pos++;// [ 或 {
+                stack.push(is_object);
+                if (stats) {
+                    ++(is_object ? stats->objects : stats->arrays);
+                    ++stats->structural_bytes;
+                    stats->max_depth = std::max(stats->max_depth, stack.size());
+                }
+                time_open();
+                return is_object ? handler.start_object() : handler.start_array();
+            }
+
+            // 关闭所有已经结束的容器, 停在下一个成员或元素之前; 宽松模式下逗号可以省略, 也可以多一个
+            // after_value 为 false 表示刚打开容器, 此时不能出现逗号
+            auto close_finished(bool after_value) -> bool {
+                while (!stack.empty()) {
+                    skip_whitespace();
+                    bool comma = false;
+                    if (after_value && pos < json_str.size() && json_str[pos] == ',') {
+                        pos++;// ,
+                        comma = true;
+                        count(&ParseStats::structural_bytes);
+                        skip_whitespace();
+                    }
+                    if (pos >= json_str.size()) {
+                        return false;  // 容器没有结束
+                    }
+                    const auto is_object = stack.top();
+                    if (json_str[pos] != (is_object ? '}' : ']')) {
+                        return !strict || comma || !after_value;
+                    }
+                    if (strict && comma) {
+                        return false;  // 尾随逗号
+                    }
+                    pos++;// ] 或 }
+                    count(&ParseStats::structural_bytes);
+                    time_close(is_object);
+                    stack.pop();
+                    if (!(is_object ? handler.end_object() : handler.end_array())) {
+                        return false;
+                    }
+                    after_value = true;
+                }
+                return true;
+            }
+
+            // 对象成员的键与其后的冒号(宽松模式下可以省略)
+            auto parse_key() -> bool {
+                if (json_str[pos] != '"') {
+                    return false;
+                }
+                const auto key = scan_string();
+                count(&ParseStats::keys);
+                if (!key || !handler.key(*key)) {
+                    return false;
+                }
+                skip_whitespace();
+                if (pos < json_str.size() && json_str[pos] == ':') {
+                    pos++;// :
+                    count(&ParseStats::structural_bytes);
+                } else if (strict) {
+                    return false;
+                }
+                return true;
+            }
+
+        public:
+            // scratch_buffer 由调用者持有时, 它的容量在多次解析之间保留, 稳态下解码转义不再分配
+            SaxParser(std::string_view json_str, Handler& handler, size_t max_depth = default_max_depth,
+                      ParseStats* stats = nullptr, std::string* scratch_buffer = nullptr)
+                : json_str(json_str), max_depth(max_depth), handler(handler),
+                  scratch(scratch_buffer ? *scratch_buffer : local_scratch), stats(stats) {}
+            SaxParser(const SaxParser&) = delete;
+            auto operator=(const SaxParser&) -> SaxParser& = delete;
+
+            // 严格模式见类前的说明, 需要在 parse 之前设置
+            void set_strict(bool enable) {
+                strict = enable;
+            }
+
+            // 解析一个完整的值; 宽松模式下其后的内容不检查, 严格模式下只能是空白
+            auto parse() -> bool {
+                const auto start_pos = pos;
+                bool ok = parse_value();
+                if (ok && strict) {
+                    skip_whitespace();
+                    ok = pos == json_str.size();
+                }
+                if (stats) {
+                    ++stats->documents;
+                    stats->bytes += pos - start_pos;
+                }
+                return ok;
+            }
+
+            // 用显式的容器栈代替递归, 调用栈的深度与文档的嵌套层数无关
+            auto parse_value() -> bool {
+                stack.clear();
+#ifdef JSON_PARSE_TIMING
+                open_times.clear();
+#endif
+                while (true) {
+                    skip_whitespace();
+                    if (pos >= json_str.size()) {
+                        return false;
+                    }
+                    const auto ch = json_str[pos];
+                    const bool is_container = ch == '[' || ch == '{';
+                    if (!(is_container ? open(ch == '{') : parse_scalar())) {
+                        return false;
+                    }
+                    if (!close_finished(!is_container)) {
+                        return false;
+                    }
+                    if (stack.empty()) {
+                        return true;
+                    }
+                    if (stack.top() && !parse_key()) {
+                        return false;
+                    }
+                }
+            }
+
+            // 解析停止的位置, 出错时即为出错的位置
+            [[nodiscard]] auto position() const -> size_t {
+                return pos;
+            }
+
+            // 解码缓冲区与容器栈在这次解析中的扩容
+            [[nodiscard]] auto heap_stats() const -> HeapStats {
+                auto heap = scratch_heap;
+                heap += stack.heap_stats();
+                return heap;
+            }
+        };
+
+        // SAX 方式驱动解析; stats 非空时把统计累加进去
+        // 反复解析时传入同一个 scratch, 含转义的字符串解码用的缓冲区在各次之间复用
+        template<SaxHandler Handler>
+        auto parse_sax(std::string_view json_str, Handler& handler, size_t max_depth = default_max_depth,
+                       ParseStats* stats = nullptr, std::string* scratch = nullptr) -> bool {
+            return SaxParser<Handler>{json_str, handler, max_depth, stats, scratch}.parse();
+        }
+
+        // 把 SAX 事件构造成 Node 树的 handler, 子节点直接构造在父容器里
+        class DomBuilder {
+        protected:
+            std::pmr::memory_resource* resource;
+            Node root;
+            // 非空时对象的键驻留到这里, 而不是为每个成员复制一份
+            JsonNode::KeyPool* keys = nullptr;
+            // 尚未结束的容器; 只有栈顶会追加成员, 所以下层的指针一直有效
+            std::vector<Node*> stack;
+            HeapStats stack_heap;  // stack 的扩容, 跨文档累计
+            // 对象中已插入、等待赋值的成员
+            Node* pending = nullptr;
+            // 元素个数不少于此值的同类数字数组存为紧凑数组, 0 表示不启用
+            size_t pack_threshold = 0;
+
+            // 下一个值应该写入的位置; 紧凑数组中出现其他类型的值时先展开
+            auto slot() -> Node& {
+                if (stack.empty()) {
+                    return root;
+                }
+                auto& top = *stack.back();
+                if (top.is_packed()) {
+                    top.unpack();
+                }
+                if (auto array = top.get_if<ArrayNode>()) {
+                    return array->emplace_back();
+                }
+                return *pending;
+            }
+            // 数字直接追加到紧凑数组; 普通数组在第 pack_threshold 个元素到来且之前的元素都是同类数字时转换
+            // 短数组不受影响, 转换只发生一次; 不能追加时返回 false
+            // 整数与浮点数混合的数组(如 [0, 0.5, 1])有意不打包, 整数也不提升进 DoubleArray:
+            // 那样 1 会变成 1.0, 序列化结果与不打包时不同; 已经打包的数组遇到另一类数字时展开, 之后不再打包
+            template<typename Packed, typename Number>
+            auto pack(Number number) -> bool {
+                if (pack_threshold == 0 || stack.empty()) {
+                    return false;
+                }
+                auto& top = *stack.back();
+                if (auto packed = top.get_if<Packed>()) {
+                    packed->push_back(number);
+                    return true;
+                }
+                auto array = top.get_if<ArrayNode>();
+                if (array == nullptr || array->size() + 1 != pack_threshold ||
+                    !std::all_of(array->begin(), array->end(), [](const Node& element) { return element.is<Number>(); })) {
+                    return false;
+                }
+                Packed packed{resource};
+                packed.reserve(pack_threshold * 2);
+                for (const auto& element : *array) {
+                    packed.push_back(*element.get_if<Number>());
+                }
+                packed.push_back(number);
+                top.Value().emplace<Packed>(std::move(packed));
+                return true;
+            }
+            // 压入新开始的容器, 顺带记录栈的扩容
+            void push(Node& node) {
+                const auto capacity = stack.capacity();
+                stack.push_back(&node);
+                stack_heap.record(capacity, stack.capacity(), sizeof(Node*));
+            }
+        public:
+            explicit DomBuilder(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                                JsonNode::KeyPool* keys = nullptr)
+                : resource(resource), keys(keys) {}
+
+            void set_key_pool(JsonNode::KeyPool* pool) {
+                keys = pool;
+            }
+            // 元素全为整数或全为浮点数且不少于 min_size 个的数组存为 Int64Array/DoubleArray, 0 表示关闭
+            void set_pack_threshold(size_t min_size) {
+                pack_threshold = min_size;
+            }
+
+            auto on_null() -> bool {
+                slot().Value().emplace<MonoNode>();
+                return true;
+            }
+            auto on_bool(BoolNode value) -> bool {
+                slot().Value().emplace<BoolNode>(value);
+                return true;
+            }
+            auto on_int(IntNode value) -> bool {
+                if (!pack<JsonNode::Int64Array>(value)) {
+                    slot().Value().emplace<IntNode>(value);
+                }
+                return true;
+            }
+            auto on_double(FloatNode value) -> bool {
+                if (!pack<JsonNode::DoubleArray>(value)) {
+                    slot().Value().emplace<FloatNode>(value);
+                }
+                return true;
+            }
+            auto on_string(std::string_view value) -> bool {
+                slot().Value().emplace<StringNode>(value, resource);
+                return true;
+            }
+            auto start_object() -> bool {
+                auto& node = slot();
+                node.Value().emplace<ObjectNode>(resource);
+                push(node);
+                return true;
+            }
+            // 重复的键沿用原位置, 值被后出现的覆盖; 超过 Key::max_size 的键使解析失败
+            auto key(std::string_view name) -> bool {
+                if (name.size() > JsonNode::Key::max_size) {
+                    return false;
+                }
+                auto& object = *stack.back()->get_if<ObjectNode>();
+                pending = keys ? &object[keys->intern(name)] : &object[name];
+                return true;
+            }
+            auto end_object() -> bool {
+                stack.pop_back();
+                return true;
+            }
+            auto start_array() -> bool {
+                auto& node = slot();
+                node.Value().emplace<ArrayNode>(resource);
+                push(node);
+                return true;
+            }
+            auto end_array() -> bool {
+                stack.pop_back();
+                return true;
+            }
+
+            // 取出构造完成的树, 并为下一个文档做准备(保留栈的容量)
+            auto take() -> Node {
+                stack.clear();
+                pending = nullptr;
+                return std::move(root);
+            }
+            void reset(std::pmr::memory_resource* new_resource) {
+                resource = new_resource;
+                root = Node{};
+                stack.clear();
+                pending = nullptr;
+            }
+
+            // 容器栈自构造以来的扩容
+            [[nodiscard]] auto heap_stats() const -> const HeapStats& {
+                return stack_heap;
+            }
+        };
+
+        // 按树的结构依次把事件交给 handler, 紧凑数组展开成普通的数组事件; handler 返回 false 时停止并返回 false
+        // 与 Serializer 一样用显式栈代替递归, 调用栈的深度与树的嵌套层数无关
+        template<SaxHandler Handler>
+        auto replay(const Node& root, Handler& handler) -> bool {
+            struct Frame {
+                const ArrayNode* array;
+                const ObjectNode* object;
+                size_t next;
+            };
+            std::vector<Frame> stack;
+            // 标量与紧凑数组直接产生事件, 普通容器只产生开始事件并入栈
+            const auto value = [&](const Node& node) -> bool {
+                return std::visit(
+                    [&]<typename T0>(const T0& arg) -> bool {
+                        using T = std::decay_t<T0>;
+                        if constexpr (std::is_same_v<T, MonoNode>) {
+                            return handler.on_null();
+                        } else if constexpr (std::is_same_v<T, BoolNode>) {
+                            return handler.on_bool(arg);
+                        } else if constexpr (std::is_same_v<T, IntNode>) {
+                            return handler.on_int(arg);
+                        } else if constexpr (std::is_same_v<T, FloatNode>) {
+                            return handler.on_double(arg);
+                        } else if constexpr (std::is_same_v<T, StringNode>) {
+                            return handler.on_string(arg);
+                        } else if constexpr (std::is_same_v<T, ArrayNode>) {
+                            stack.push_back({&arg, nullptr, 0});
+                            return handler.start_array();
+                        } else if constexpr (std::is_same_v<T, ObjectNode>) {
+                            stack.push_back({nullptr, &arg, 0});
+                            return handler.start_object();
+                        } else {
+                            if (!handler.start_array()) return false;
+                            for (const auto number : arg) {
+                                if constexpr (std::is_same_v<T, JsonNode::Int64Array>) {
+                                    if (!handler.on_int(number)) return false;
+                                } else {
+                                    if (!handler.on_double(number)) return false;
+                                }
+                            }
+                            return handler.end_array();
+                        }
+                    },
+                    node.Value());
+            };
+            if (!value(root)) {
+                return false;
+            }
+            while (!stack.empty()) {
+                auto& frame = stack.back();
+                const auto size = frame.array ? frame.array->size() : frame.object->size();
+                if (frame.next == size) {
+                    const bool is_array = frame.array != nullptr;
+                    stack.pop_back();
+                    if (!(is_array ? handler.end_array() : handler.end_object())) {
+                        return false;
+                    }
+                    continue;
+                }
+                const auto index = frame.next++;
+                if (frame.array) {
+                    if (!value((*frame.array)[index])) return false;  // 可能使 frame 失效
+                } else {
+                    const auto& [name, element] = *(frame.object->begin() + static_cast<std::ptrdiff_t>(index));
+                    if (!handler.key(name) || !value(element)) return false;
+                }
+            }
+            return true;
+        }
+
+        class Parser {
+        protected:
+            std::string_view json_str;
+            // 整棵树的字符串与容器都从这里分配
+            std::pmr::memory_resource* resource;
+            // 仅在可复用模式下持有, 在多次解析之间保留已申请的内存
+            std::unique_ptr<JsonMemory::Arena> arena;
+            DomBuilder builder;
+            std::string scratch;  // 解码转义的缓冲区, reset 后保留容量
+            HeapStats parser_heap;  // 各次解析中 scratch 与语法栈的扩容
+            size_t max_depth = default_max_depth;
+            bool strict = false;
+            ParseStats* statistics = nullptr;
+
+            // 能够读到分配计数的资源: 自带的 arena 或 CountingResource
+            [[nodiscard]] auto allocation_counters() const -> std::pair<size_t, size_t> {
+                if (auto counted = dynamic_cast<const JsonMemory::Arena*>(resource)) {
+                    return {counted->stats().allocations, counted->stats().bytes};
+                }
+                if (auto counted = dynamic_cast<const JsonMemory::CountingResource*>(resource)) {
+                    return {counted->stats().allocations, counted->stats().bytes};
+                }
+                return {0, 0};
+            }
+
+        public:
+            explicit Parser(std::string_view json_str,
+                            std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+                : json_str(json_str), resource(resource), builder(resource) {}
+
+            // 可复用模式: 解析结果分配在解析器自带的 arena 上, 只在下一次 reset 之前有效
+            // 调用 reset 前必须先销毁上一次得到的节点
+            explicit Parser(size_t initial_capacity = 4096)
+                : arena(std::make_unique<JsonMemory::Arena>(initial_capacity)) {
+                resource = arena.get();
+                builder.reset(resource);
+            }
+
+            // 嵌套超过 depth 层的文档直接判为失败
+            void set_max_depth(size_t depth) {
+                max_depth = depth;
+            }
+
+            // 按 SaxParser 的严格模式解析, 默认宽松
+            void set_strict(bool enable) {
+                strict = enable;
+            }
+
+            // 之后解析的对象键都驻留到 pool 中, pool 必须比得到的节点活得久; 传入 nullptr 恢复逐个复制
+            void set_key_pool(JsonNode::KeyPool* pool) {
+                builder.set_key_pool(pool);
+            }
+
+            // 不少于 min_size 个元素的同类数字数组解析为 Int64Array/DoubleArray, 0(默认)表示关闭
+            // 整数与浮点数混合的数组保持为 ArrayNode, 见 DomBuilder::pack
+            void set_pack_threshold(size_t min_size) {
+                builder.set_pack_threshold(min_size);
+            }
+
+            // 切换到新的输入并回卷 arena
+            void reset(std::string_view new_json_str) {
+                json_str = new_json_str;
+                builder.reset(resource);
+                if (arena) {
+                    arena->reset();
+                }
+            }
+
+            // arena 的计数只有可复用模式才有; heap_* 是解析器自身的缓冲区(解码转义的 scratch 与两个栈)
+            // 直接向堆申请的次数与字节数, 两种模式都统计; 稳态下 heap_allocations 与 upstream_allocations 都不再增长,
+            // 只有嵌套超过 default_max_depth 的文档每次都要为语法栈重新申请
+            [[nodiscard]] auto stats() const -> MemoryStats {
+                MemoryStats result;
+                if (arena) {
+                    static_cast<JsonMemory::ArenaStats&>(result) = arena->stats();
+                }
+                result.heap_allocations = parser_heap.allocations + builder.heap_stats().allocations;
+                result.heap_bytes = parser_heap.bytes + builder.heap_stats().bytes;
+                return result;
+            }
+
+            // 之后每次解析的统计都累加到 stats 中, stats 由调用者持有; 传入 nullptr 停止统计
+            void set_stats(ParseStats* stats) {
+                statistics = stats;
+            }
+
+            auto parse() ->std::optional<Node> {
+                const auto before = statistics ? allocation_counters() : std::pair<size_t, size_t>{};
+                SaxParser<DomBuilder> parser{json_str, builder, max_depth, statistics, &scratch};
+                parser.set_strict(strict);
+                const bool ok = parser.parse();
+                parser_heap += parser.heap_stats();
+                if (statistics) {
+                    const auto after = allocation_counters();
+                    statistics->allocations += after.first - before.first;
+                    statistics->allocated_bytes += after.second - before.second;
+                }
+                if (!ok) {
+                    builder.reset(resource);
+                    return {};
+                }
+                return builder.take();
+            }
+        };
+    }
+
+    namespace JsonValidate {
+        enum class Error {
+            None,
+            InvalidUtf8,
+            UnexpectedEnd,        // 输入在值、字符串或容器结束之前结束
+            UnexpectedCharacter,  // 出现在不允许的位置, 包括缺少的逗号与冒号
+            InvalidNumber,
+            InvalidLiteral,
+            InvalidString,        // 字符串中未转义的控制字符
+            InvalidEscape,        // 未知的转义、不完整的 \u 与落单的代理项
+            TooDeep,
+            TrailingContent,
+            TooLarge,             // 超过 4GB, 结构索引无法表示
+        };
+
+        inline auto message(Error error) -> std::string_view {
+            switch (error) {
+                case Error::None: return "ok";
+                case Error::InvalidUtf8: return "invalid UTF-8";
+                case Error::UnexpectedEnd: return "unexpected end of input";
+                case Error::UnexpectedCharacter: return "unexpected character";
+                case Error::InvalidNumber: return "invalid number";
+                case Error::InvalidLiteral: return "invalid literal";
+                case Error::InvalidString: return "unescaped control character in string";
+                case Error::InvalidEscape: return "invalid escape sequence";
+                case Error::TooDeep: return "nesting too deep";
+                case Error::TrailingContent: return "trailing content after value";
+                case Error::TooLarge: return "input too large";
+            }
+            return "unknown error";
+        }
+
+        struct Result {
+            Error error = Error::None;
+            size_t offset = 0;  // 出错的字节位置
+
+            explicit operator bool() const { return error == Error::None; }
+        };
+
+        // 严格按 RFC 8259 检查(之前与之后只允许空白), 不构造任何节点
+        // 先整体检查 UTF-8, 再用向量化的结构字符索引逐个检查记号, 字符串内容由 find_escapable 成块跳过
+        class Validator {
+        protected:
+            std::string_view text;
+            size_t max_depth;
+            std::vector<uint32_t> index;
+            size_t next = 0;    // index 中下一个结构字符
+            size_t cursor = 0;  // 输入中的当前位置
+            JsonParser::ContainerStack stack;
+
+            auto fail(Error error, size_t offset) const -> Result {
+                return {error, offset};
+            }
+
+            void skip_whitespace() {
+                const auto begin = text.data();
+                cursor = static_cast<size_t>(JsonScan::skip_whitespace(begin + cursor, begin + text.size()) - begin);
+            }
+            // 当前位置是否是一个结构字符
+            [[nodiscard]] auto at_structural() const -> bool {
+                return next < index.size() && index[next] == cursor;
+            }
+
+            // cursor 指向开头引号, 结尾引号一定是索引中的下一项
+            auto check_string() -> Result {
+                const auto open = cursor;
+                const auto close = static_cast<size_t>(index[next + 1]);
+                const auto begin = text.data();
+                auto first = begin + open + 1;
+                const auto last = begin + close;
+                while (true) {
+                    const auto hit = JsonScan::find_escapable(first, last);
+                    if (hit == last) {
+                        break;
+                    }
+                    if (*hit != '\\') {
+                        return fail(Error::InvalidString, static_cast<size_t>(hit - begin));
+                    }
+                    first = check_escape(hit, last);
+                    if (first == nullptr) {
+                        return fail(Error::InvalidEscape, static_cast<size_t>(hit - begin));
+                    }
+                }
+                next += 2;
+                cursor = close + 1;
+                return {};
+            }
+            // 与 JsonScan::unescape 接受的转义一致, 返回转义之后的位置
+            static auto check_escape(const char* first, const char* last) -> const char* {
+                if (last - first < 2) {
+                    return nullptr;
+                }
+                switch (first[1]) {
+                    case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                        return first + 2;
+                    case 'u': {
+                        uint32_t code_point = 0;
+                        if (last - first < 6 || !JsonScan::parse_hex4(first + 2, code_point) ||
+                            (code_point >= 0xdc00 && code_point <= 0xdfff)) {
+                            return nullptr;
+                        }
+                        if (code_point < 0xd800 || code_point > 0xdbff) {
+                            return first + 6;
+                        }
+                        uint32_t low = 0;
+                        if (last - first < 12 || first[6] != '\\' || first[7] != 'u' || !JsonScan::parse_hex4(first + 8, low) ||
+                            low < 0xdc00 || low > 0xdfff) {
+                            return nullptr;
+                        }
+                        return first + 12;
+                    }
+                    default:
+                        return nullptr;
+                }
+            }
+
+            // 数字或字面量, 只能延伸到下一个结构字符之前
+            auto check_scalar() -> Result {
+                const auto begin = text.data();
+                const auto limit = begin + (next < index.size() ? index[next] : text.size());
+                const auto first = begin + cursor;
+                const char* end = nullptr;
+                auto error = Error::InvalidNumber;
+                switch (*first) {
+                    case 't': end = JsonScan::skip_literal(first, limit, "true"); error = Error::InvalidLiteral; break;
+                    case 'f': end = JsonScan::skip_literal(first, limit, "false"); error = Error::InvalidLiteral; break;
+                    case 'n': end = JsonScan::skip_literal(first, limit, "null"); error = Error::InvalidLiteral; break;
+                    default:
+                        if (*first != '-' && !JsonScan::is_digit(*first)) {
+                            return fail(Error::UnexpectedCharacter, cursor);
+                        }
+                        bool is_float = false;
+                        end = JsonScan::skip_number(first, limit, is_float);
+                        break;
+                }
+                if (end == nullptr) {
+                    return fail(error, cursor);
+                }
+                cursor = static_cast<size_t>(end - begin);
+                return {};
+            }
+
+            // 一个值; 容器只检查开括号并入栈
+            auto check_value() -> Result {
+                skip_whitespace();
+                if (cursor == text.size()) {
+                    return fail(Error::UnexpectedEnd, cursor);
+                }
+                if (!at_structural()) {
+                    return check_scalar();
+                }
+                switch (text[cursor]) {
+                    case '"':
+                        return check_string();
+                    case '[':
+                    case '{':
+                        if (stack.size() >= max_depth) {
+                            return fail(Error::TooDeep, cursor);
+                        }
+                        stack.push(text[cursor] == '{');
+                        ++next;
+                        ++cursor;
+                        return {};
+                    default:
+                        return fail(Error::UnexpectedCharacter, cursor);
+                }
+            }
+
+            // 读取期望的结构字符 expected, 不是时返回 false 且不移动
+            auto consume(char expected) -> bool {
+                skip_whitespace();
+                if (!at_structural() || text[cursor] != expected) {
+                    return false;
+                }
+                ++next;
+                ++cursor;
+                return true;
+            }
+            auto here_or_end() -> Result {
+                return fail(cursor == text.size() ? Error::UnexpectedEnd : Error::UnexpectedCharacter, cursor);
+            }
+
+            // 键与冒号
+            auto check_key() -> Result {
+                skip_whitespace();
+                if (!at_structural() || text[cursor] != '"') {
+                    return here_or_end();
+                }
+                if (auto result = check_string(); !result) {
+                    return result;
+                }
+                return consume(':') ? Result{} : here_or_end();
+            }
+        public:
+            explicit Validator(std::string_view text, size_t max_depth = JsonParser::default_max_depth)
+                : text(text), max_depth(max_depth) {}
+
+            auto run() -> Result {
+                const auto begin = text.data();
+                if (const auto bad = JsonScan::validate_utf8(begin, begin + text.size()); bad != begin + text.size()) {
+                    return fail(Error::InvalidUtf8, static_cast<size_t>(bad - begin));
+                }
+                if (text.size() > UINT32_MAX) {
+                    return fail(Error::TooLarge, 0);
+                }
+                if (!JsonScan::build_structural_index(text, index)) {
+                    return fail(Error::UnexpectedEnd, text.size());  // 字符串没有结束
+                }
+                next = cursor = 0;
+                stack.clear();
+                if (auto result = check_value(); !result) {
+                    return result;
+                }
+                bool opened = !stack.empty();  // 刚读过开括号: 可以直接关闭, 不能出现逗号
+                while (!stack.empty()) {
+                    const bool is_object = stack.top();
+                    if (consume(is_object ? '}' : ']')) {
+                        stack.pop();
+                        opened = false;
+                        continue;
+                    }
+                    if (!opened && !consume(',')) {
+                        return here_or_end();
+                    }
+                    if (is_object) {
+                        if (auto result = check_key(); !result) return result;
+                    }
+                    const auto depth = stack.size();
+                    if (auto result = check_value(); !result) {
+                        return result;
+                    }
+                    opened = stack.size() > depth;
+                }
+                skip_whitespace();
+                if (cursor != text.size()) {
+                    return fail(Error::TrailingContent, cursor);
+                }
+                return {};
+            }
+        };
+
+        // 严格检查 text 是否是一个完整的 json 文档, 失败时给出原因与位置
+        // 只检查文法, 不转换数字; 超出 double 范围的数字解析时按 strtod 的约定饱和为 ±HUGE_VAL 或零
+        inline auto validate(std::string_view text, size_t max_depth = JsonParser::default_max_depth) -> Result {
+            return Validator{text, max_depth}.run();
+        }
+    }
+
+    namespace JsonOnDemand {
+        using JsonNode::Node;
+        using JsonNode::BoolNode, JsonNode::IntNode, JsonNode::FloatNode;
+
+        enum class Type { Null, Bool, Number, String, Array, Object, Invalid };
+
+        struct ArrayRange;
+        struct ObjectRange;
+
+        // 指向输入缓冲区中某个值的轻量句柄, 只保存位置, 不拥有也不复制数据
+        // 访问时才解码; 查找成员或元素时跳过的子树既不分配也不构造节点
+        class Value {
+            friend class ArrayIterator;
+            friend class ObjectIterator;
+        protected:
+            std::string_view json_str;
+            size_t pos = 0;
+
+            [[nodiscard]] auto begin_ptr() const -> const char* { return json_str.data(); }
+            [[nodiscard]] auto end_ptr() const -> const char* { return json_str.data() + json_str.size(); }
+            [[nodiscard]] auto make(const char* at) const -> Value {
+                return Value{json_str, static_cast<size_t>(at - begin_ptr())};
+            }
+            [[nodiscard]] auto skip_whitespace(const char* at) const -> const char* {
+                return JsonScan::skip_whitespace(at, end_ptr());
+            }
+        public:
+            Value() = default;
+            Value(std::string_view json_str, size_t pos) : json_str(json_str), pos(pos) {}
+
+            // 定位到输入中的第一个值, 输入为空时返回空
+            static auto from_str(std::string_view json_str) -> std::optional<Value> {
+                Value value{json_str, 0};
+                value.pos = static_cast<size_t>(value.skip_whitespace(value.begin_ptr()) - value.begin_ptr());
+                if (value.pos == json_str.size()) {
+                    return {};
+                }
+                return value;
+            }
+
+            [[nodiscard]] auto type() const -> Type {
+                if (pos >= json_str.size()) {
+                    return Type::Invalid;
+                }
+                switch (json_str[pos]) {
+                    case 'n': return Type::Null;
+                    case 't': case 'f': return Type::Bool;
+                    case '"': return Type::String;
+                    case '[': return Type::Array;
+                    case '{': return Type::Object;
+                    default: return (json_str[pos] == '-' || JsonScan::is_digit(json_str[pos])) ? Type::Number : Type::Invalid;
+                }
+            }
+
+            // 该值在输入中的完整文本
+            [[nodiscard]] auto raw() const -> std::string_view {
+                const auto end = JsonScan::skip_value(begin_ptr() + pos, end_ptr());
+                if (end == nullptr) {
+                    return {};
+                }
+                return json_str.substr(pos, static_cast<size_t>(end - begin_ptr()) - pos);
+            }
+
+            [[nodiscard]] auto is_null() const -> bool {
+                return JsonScan::skip_literal(begin_ptr() + pos, end_ptr(), "null") != nullptr;
+            }
+
+            // 支持 BoolNode, IntNode, FloatNode, std::string(解码后的内容)以及 std::string_view(引号内的原始内容)
+            // 整数也可以按 FloatNode 读取
+            template<typename Ty>
+            [[nodiscard]] auto as() const -> std::optional<Ty> {
+                const auto first = begin_ptr() + pos;
+                if constexpr (std::is_same_v<Ty, BoolNode>) {
+                    if (JsonScan::skip_literal(first, end_ptr(), "true")) return true;
+                    if (JsonScan::skip_literal(first, end_ptr(), "false")) return false;
+                    return {};
+                } else if constexpr (std::is_same_v<Ty, IntNode>) {
+                    const auto number = JsonScan::scan_number(first, end_ptr());
+                    if (number.end == nullptr || number.is_float) return {};
+                    return number.integer;
+                } else if constexpr (std::is_same_v<Ty, FloatNode>) {
+                    const auto number = JsonScan::scan_number(first, end_ptr());
+                    if (number.end == nullptr) return {};
+                    return number.is_float ? number.floating : static_cast<FloatNode>(number.integer);
+                } else if constexpr (std::is_same_v<Ty, std::string_view>) {
+                    if (type() != Type::String) return {};
+                    const auto end = JsonScan::scan_string(first + 1, end_ptr());
+                    if (end == nullptr) return {};
+                    return std::string_view{first + 1, static_cast<size_t>(end - first - 1)};
+                } else if constexpr (std::is_same_v<Ty, std::string>) {
+                    std::string scratch;
+                    const auto str = get_string(scratch);
+                    if (!str) return {};
+                    return str->data() == scratch.data() ? std::move(scratch) : std::string{*str};
+                } else {
+                    static_assert(!sizeof(Ty), "unsupported on-demand type");
+                }
+            }
+
+            // 解码后的字符串: 没有转义时直接引用输入, 否则解码到 scratch 中
+            [[nodiscard]] auto get_string(std::string& scratch) const -> std::optional<std::string_view> {
+                if (type() != Type::String) return {};
+                const auto first = begin_ptr() + pos;
+                bool escaped = false;
+                const auto end = JsonScan::scan_string(first + 1, end_ptr(), escaped);
+                if (end == nullptr) return {};
+                return JsonScan::decode_string({first + 1, static_cast<size_t>(end - first - 1)}, escaped, scratch);
+            }
+
+            // 只用于前向遍历; 不是对应的容器时返回空区间
+            [[nodiscard]] auto elements() const -> ArrayRange;
+            [[nodiscard]] auto fields() const -> ObjectRange;
+
+            // 查找成员, 途经的其他成员只被跳过
+            [[nodiscard]] auto find(std::string_view key) const -> std::optional<Value>;
+            [[nodiscard]] auto operator[](std::string_view key) const -> std::optional<Value> {
+                return find(key);
+            }
+            [[nodiscard]] auto at(size_t index) const -> std::optional<Value>;
+
+            // 需要完整子树时再把这一部分构造成 Node
+            [[nodiscard]] auto to_node() const -> std::optional<Node> {
+                const auto text = raw();
+                if (text.empty()) {
+                    return {};
+                }
+                return JsonParser::Parser{text}.parse();
+            }
+        };
+
+        // 逐个访问数组元素
+        class ArrayIterator {
+        protected:
+            Value current;
+            bool done = true;
+        public:
+            ArrayIterator() = default;
+            explicit ArrayIterator(const Value& array) : current(array) {
+                const auto first = current.skip_whitespace(current.begin_ptr() + current.pos + 1);  // [
+                done = first == current.end_ptr() || *first == ']';
+                current = current.make(first);
+            }
+
+            auto operator*() const -> const Value& { return current; }
+            auto operator->() const -> const Value* { return &current; }
+            auto operator++() -> ArrayIterator& {
+                auto cursor = JsonScan::skip_value(current.begin_ptr() + current.pos, current.end_ptr());
+                if (cursor != nullptr) cursor = current.skip_whitespace(cursor);
+                if (cursor == nullptr || cursor == current.end_ptr() || *cursor != ',') {
+                    done = true;
+                    return *this;
+                }
+                current = current.make(current.skip_whitespace(cursor + 1));
+                return *this;
+            }
+            auto operator==(const ArrayIterator& rhs) const -> bool {
+                return done == rhs.done && (done || current.pos == rhs.current.pos);
+            }
+        };
+
+        struct ArrayRange {
+            Value array;
+            [[nodiscard]] auto begin() const -> ArrayIterator { return array.type() == Type::Array ? ArrayIterator{array} : ArrayIterator{}; }
+            [[nodiscard]] auto end() const -> ArrayIterator { return {}; }
+        };
+
+        // 逐个访问对象成员, name() 为引号内的原始内容
+        class ObjectIterator {
+        protected:
+            Value object;
+            std::string_view key;
+            bool key_escaped = false;
+            Value current;
+            bool done = true;
+
+            void read_member(const char* cursor) {
+                done = true;
+                if (cursor == object.end_ptr() || *cursor != '"') return;
+                const auto key_end = JsonScan::scan_string(cursor + 1, object.end_ptr(), key_escaped);
+                if (key_end == nullptr) return;
+                key = std::string_view{cursor + 1, static_cast<size_t>(key_end - cursor - 1)};
+                cursor = object.skip_whitespace(key_end + 1);
+                if (cursor == object.end_ptr() || *cursor != ':') return;
+                current = object.make(object.skip_whitespace(cursor + 1));
+                done = false;
+            }
+        public:
+            ObjectIterator() = default;
+            explicit ObjectIterator(const Value& object) : object(object) {
+                read_member(object.skip_whitespace(object.begin_ptr() + object.pos + 1));  // {
+            }
+
+            auto operator*() const -> std::pair<std::string_view, Value> { return {key, current}; }
+            [[nodiscard]] auto name() const -> std::string_view { return key; }
+            // 解码后的键, 没有转义时直接引用输入; 转义不合法时返回原始内容
+            [[nodiscard]] auto name(std::string& scratch) const -> std::string_view {
+                return JsonScan::decode_string(key, key_escaped, scratch).value_or(key);
+            }
+            [[nodiscard]] auto value() const -> const Value& { return current; }
+            auto operator++() -> ObjectIterator& {
+                auto cursor = JsonScan::skip_value(current.begin_ptr() + current.pos, current.end_ptr());
+                if (cursor != nullptr) cursor = current.skip_whitespace(cursor);
+                if (cursor == nullptr || cursor == current.end_ptr() || *cursor != ',') {
+                    done = true;
+                    return *this;
+                }
+                read_member(object.skip_whitespace(cursor + 1));
+                return *this;
+            }
+            auto operator==(const ObjectIterator& rhs) const -> bool {
+                return done == rhs.done && (done || current.pos == rhs.current.pos);
+            }
+        };
+
+        struct ObjectRange {
+            Value object;
+            [[nodiscard]] auto begin() const -> ObjectIterator { return object.type() == Type::Object ? ObjectIterator{object} : ObjectIterator{}; }
+            [[nodiscard]] auto end() const -> ObjectIterator { return {}; }
+        };
+
+        inline auto Value::elements() const -> ArrayRange {
+            return {*this};
+        }
+        inline auto Value::fields() const -> ObjectRange {
+            return {*this};
+        }
+
+        inline auto Value::find(std::string_view key) const -> std::optional<Value> {
+            std::string scratch;
+            for (auto it = fields().begin(); it != ObjectIterator{}; ++it) {
+                if (it.name(scratch) == key) {
+                    return it.value();
+                }
+            }
+            return {};
+        }
+
+        inline auto Value::at(size_t index) const -> std::optional<Value> {
+            for (const auto& element : elements()) {
+                if (index-- == 0) {
+                    return element;
+                }
+            }
+            return {};
+        }
+    }
+
+    namespace JsonStream {
+        using JsonNode::Node;
+        using JsonNode::BoolNode;
+        using JsonParser::SaxHandler, JsonParser::DomBuilder;
+
+        // 推送式增量解析器: 输入可以在任意字节处切开, 逐块 feed, 最后 finish; 文法是 SaxParser 的严格模式
+        // 用显式栈代替递归, 每个值一结束就通知 handler; 只有跨块的词法单元才会被复制到内部缓冲区,
+        // feed 返回后调用者即可释放该块
+        template<SaxHandler Handler>
+        class BasicIncrementalParser {
+        protected:
+            // 接下来期望的语法成分
+            enum class Expect { Value, FirstValueOrEnd, FirstKeyOrEnd, Key, Colon, CommaOrEnd, Done };
+            // 尚未结束的词法单元
+            enum class Token { None, String, Key, Number, Literal };
+
+            Handler& handler;
+            size_t max_depth;
+            std::vector<bool> stack;  // 尚未结束的容器, true 为数组
+            Expect expect = Expect::Value;
+            Token token = Token::None;
+            std::string buffer;     // 跨块的词法单元
+            bool escape = false;    // 上一块以反斜杠结束
+            bool escaped = false;   // 当前字符串中出现过转义
+            std::string scratch;    // 含转义的字符串解码到这里
+            bool failed = false;
+
+            auto fail() -> bool {
+                failed = true;
+                return false;
+            }
+
+            // 一个值已经完整
+            void after_value() {
+                expect = stack.empty() ? Expect::Done : Expect::CommaOrEnd;
+            }
+
+            auto open(bool is_array) -> bool {
+                if (stack.size() >= max_depth) {
+                    return fail();
+                }
+                stack.push_back(is_array);
+                expect = is_array ? Expect::FirstValueOrEnd : Expect::FirstKeyOrEnd;
+                return is_array ? handler.start_array() : handler.start_object();
+            }
+
+            auto close(char ch) -> bool {
+                if ((ch != ']' && ch != '}') || stack.empty() || stack.back() != (ch == ']')) {
+                    return fail();
+                }
+                stack.pop_back();
+                after_value();
+                return (ch == ']' ? handler.end_array() : handler.end_object()) || fail();
+            }
+
+            // 词法单元的完整文本: 整个单元都在当前块中时直接引用输入, 否则拼到内部缓冲区
+            auto token_text(const char* start, const char* end) -> std::string_view {
+                if (buffer.empty()) {
+                    return {start, static_cast<size_t>(end - start)};
+                }
+                buffer.append(start, end);
+                return buffer;
+            }
+
+            auto finish_string(std::string_view raw) -> bool {
+                const auto is_key = token == Token::Key;
+                token = Token::None;
+                const auto decoded = JsonScan::decode_string(raw, escaped, scratch);
+                if (!decoded) {
+                    return fail();
+                }
+                const auto text = *decoded;
+                if (is_key) {
+                    expect = Expect::Colon;
+                    return handler.key(text) || fail();
+                }
+                after_value();
+                return handler.on_string(text) || fail();
+            }
+
+            auto finish_number(std::string_view text) -> bool {
+                const auto number = JsonScan::scan_number(text.data(), text.data() + text.size());
+                token = Token::None;
+                if (number.end != text.data() + text.size()) {
+                    return fail();
+                }
+                after_value();
+                return (number.is_float ? handler.on_double(number.floating) : handler.on_int(number.integer)) || fail();
+            }
+
+            auto finish_literal(std::string_view text) -> bool {
+                token = Token::None;
+                after_value();
+                if (text == "true" || text == "false") {
+                    return handler.on_bool(text == "true") || fail();
+                }
+                if (text == "null") {
+                    return handler.on_null() || fail();
+                }
+                return fail();
+            }
+
+            // 以下 continue_* 消费当前词法单元能用到的字节, 返回停下的位置, 出错时返回 nullptr
+            auto continue_string(const char* first, const char* last) -> const char* {
+                const auto start = first;
+                if (escape) {
+                    ++first;
+                    escape = false;
+                }
+                while (true) {
+                    const auto hit = JsonScan::find_quote_or_backslash(first, last);
+                    if (hit == last) {
+                        buffer.append(start, last);
+                        return last;
+                    }
+                    if (*hit == '"') {
+                        return finish_string(token_text(start, hit)) ? hit + 1 : nullptr;
+                    }
+                    escaped = true;
+                    if (hit + 1 == last) {
+                        buffer.append(start, last);
+                        escape = true;
+                        return last;
+                    }
+                    first = hit + 2;
+                }
+            }
+
+            auto continue_number(const char* first, const char* last) -> const char* {
+                auto cursor = first;
+                while (cursor < last && (JsonScan::is_digit(*cursor) || *cursor == '-' || *cursor == '+' ||
+                                         *cursor == '.' || *cursor == 'e' || *cursor == 'E')) {
+                    ++cursor;
+                }
+                if (cursor == last) {
+                    buffer.append(first, cursor);
+                    return last;
+                }
+                return finish_number(token_text(first, cursor)) ? cursor : nullptr;
+            }
+
+            auto continue_literal(const char* first, const char* last) -> const char* {
+                auto cursor = first;
+                while (cursor < last && *cursor >= 'a' && *cursor <= 'z') {
+                    ++cursor;
+                }
+                if (cursor == last) {
+                    buffer.append(first, cursor);
+                    return last;
+                }
+                return finish_literal(token_text(first, cursor)) ? cursor : nullptr;
+            }
+
+            void begin_token(Token kind) {
+                token = kind;
+                buffer.clear();
+                escaped = false;
+            }
+
+            // 处理一个值的第一个字节
+            auto begin_value(char ch) -> bool {
+                switch (ch) {
+                    case '[':
+                    case '{':
+                        return open(ch == '[') || fail();
+                    case '"':
+                        begin_token(Token::String);
+                        return true;
+                    case 't':
+                    case 'f':
+                    case 'n':
+                        begin_token(Token::Literal);
+                        return true;
+                    default:
+                        if (ch == '-' || JsonScan::is_digit(ch)) {
+                            begin_token(Token::Number);
+                            return true;
+                        }
+                        return fail();
+                }
+            }
+        public:
+            explicit BasicIncrementalParser(Handler& handler, size_t max_depth = JsonParser::default_max_depth)
+                : handler(handler), max_depth(max_depth) {}
+
+            // 输入下一块数据, 出现语法错误或 handler 要求停止时返回 false, 此后的 feed 都会失败
+            auto feed(std::string_view chunk) -> bool {
+                if (failed) {
+                    return false;
+                }
+                auto cursor = chunk.data();
+                const auto last = cursor + chunk.size();
+                while (cursor < last) {
+                    switch (token) {
+                        case Token::String:
+                        case Token::Key:
+                            cursor = continue_string(cursor, last);
+                            break;
+                        case Token::Number:
+                            cursor = continue_number(cursor, last);
+                            break;
+                        case Token::Literal:
+                            cursor = continue_literal(cursor, last);
+                            break;
+                        case Token::None:
+                            break;
+                    }
+                    if (cursor == nullptr) {
+                        return fail();
+                    }
+                    cursor = JsonScan::skip_whitespace(cursor, last);
+                    if (cursor == last) {
+                        break;
+                    }
+
+                    const char ch = *cursor++;
+                    switch (expect) {
+                        case Expect::FirstValueOrEnd:
+                            if (ch == ']') {
+                                if (!close(ch)) return false;
+                                break;
+                            }
+                            [[fallthrough]];
+                        case Expect::Value:
+                            if (!begin_value(ch)) return false;
+                            if (token == Token::Number || token == Token::Literal) {
+                                --cursor;  // 数字与字面量的首字节也属于词法单元
+                            }
+                            break;
+                        case Expect::FirstKeyOrEnd:
+                            if (ch == '}') {
+                                if (!close(ch)) return false;
+                                break;
+                            }
+                            [[fallthrough]];
+                        case Expect::Key:
+                            if (ch != '"') return fail();
+                            begin_token(Token::Key);
+                            break;
+                        case Expect::Colon:
+                            if (ch != ':') return fail();
+                            expect = Expect::Value;
+                            break;
+                        case Expect::CommaOrEnd:
+                            if (ch == ',') {
+                                expect = stack.back() ? Expect::Value : Expect::Key;
+                            } else if (!close(ch)) {
+                                return false;
+                            }
+                            break;
+                        case Expect::Done:
+                            return fail();  // 文档之后只能是空白
+                    }
+                }
+                return true;
+            }
+
+            // 输入结束: 补完末尾的数字或字面量, 文档完整时返回 true
+            auto finish() -> bool {
+                if (!failed && token == Token::Number) {
+                    finish_number(buffer);
+                } else if (!failed && token == Token::Literal) {
+                    finish_literal(buffer);
+                }
+                return !failed && token == Token::None && expect == Expect::Done;
+            }
+
+            // 开始下一个文档, 保留内部缓冲区的容量
+            void reset() {
+                stack.clear();
+                expect = Expect::Value;
+                token = Token::None;
+                buffer.clear();
+                escape = false;
+                failed = false;
+            }
+
+            // 当前容器的嵌套深度
+            [[nodiscard]] auto depth() const -> size_t {
+                return stack.size();
+            }
+        };
+
+        // 增量构造 Node 树
+        class IncrementalParser {
+        protected:
+            std::pmr::memory_resource* resource;
+            DomBuilder builder;
+            BasicIncrementalParser<DomBuilder> parser;
+        public:
+            explicit IncrementalParser(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                                       size_t max_depth = JsonParser::default_max_depth)
+                : resource(resource), builder(resource), parser(builder, max_depth) {}
+            IncrementalParser(const IncrementalParser&) = delete;
+            auto operator=(const IncrementalParser&) -> IncrementalParser& = delete;
+
+            auto feed(std::string_view chunk) -> bool {
+                return parser.feed(chunk);
+            }
+
+            // 输入结束, 文档完整时返回根节点
+            auto finish() -> std::optional<Node> {
+                if (!parser.finish()) {
+                    return {};
+                }
+                return builder.take();
+            }
+
+            void reset() {
+                parser.reset();
+                builder.reset(resource);
+            }
+
+            [[nodiscard]] auto depth() const -> size_t {
+                return parser.depth();
+            }
+        };
+    }
+
+    namespace JsonDocument {
+        using JsonNode::Node;
+
+        // 拥有一块单调增长 arena 的文档: 整棵树从 arena 分配, 销毁时整块归还
+        // 注意: 从文档中移出的节点仍引用该 arena, 不能比文档活得更久; 需要脱离文档时请拷贝
+        class Document {
+        protected:
+            // arena 必须先于 root 构造、晚于 root 析构
+            std::unique_ptr<JsonMemory::Arena> arena;
+            Node root;
+
+            explicit Document(size_t initial_size)
+                : arena(std::make_unique<JsonMemory::Arena>(initial_size)) {}
+        public:
+            Document(Document&&) noexcept = default;
+            auto operator=(Document&& rhs) noexcept -> Document& {
+                if (this != &rhs) {
+                    // 先释放旧树再换 arena, 避免旧节点向已销毁的 arena 归还内存
+                    root = Node{};
+                    arena = std::move(rhs.arena);
+                    root = std::move(rhs.root);
+                    rhs.root = Node{};
+                }
+                return *this;
+            }
+
+            // keys 非空时对象键驻留到这个池中, 多个文档可以共享同一个池
+            static auto parse(std::string_view json_str, size_t initial_size = 4096,
+                              JsonNode::KeyPool* keys = nullptr) -> std::optional<Document> {
+                // 不按输入大小预留: 宽数组的缓冲区走单独的大块, 预留的普通块大多用不上; 普通块按倍数增长, 次数只是对数级
+                Document document{initial_size};
+                JsonParser::Parser parser{json_str, document.arena.get()};
+                parser.set_key_pool(keys);
+                auto node = parser.parse();
+                if (!node) {
+                    return {};
+                }
+                document.root = std::move(*node);
+                return document;
+            }
+
+            auto Root() -> Node& {
+                return root;
+            }
+            [[nodiscard]] auto Root() const -> const Node& {
+                return root;
+            }
+            [[nodiscard]] auto resource() const -> std::pmr::memory_resource* {
+                return arena.get();
+            }
+        };
+    }
+
+    namespace JsonParallel {
+        using JsonNode::Node;
+        using JsonNode::ArrayNode, JsonNode::ObjectNode;
+
+        struct Options {
+            // 0 表示使用硬件线程数
+            size_t threads = 0;
+            // 输入小于该值时直接串行解析
+            size_t min_parallel_bytes = 1 << 20;
+            // 各线程同时在上面分配, 必须是线程安全的
+            std::pmr::memory_resource* resource = std::pmr::new_delete_resource();
+            // 包括根容器在内的最大嵌套深度, 与串行解析相同
+            size_t max_depth = JsonParser::default_max_depth;
+        };
+
+        // 在 count 个线程上运行 task(i), 当前线程承担第 0 个; 任务中的异常在汇合后重新抛出; count 为 0 时什么也不做
+        template<typename Task>
+        void run_parallel(size_t count, Task&& task) {
+            if (count == 0) {
+                return;
+            }
+            std::vector<std::exception_ptr> errors(count);
+            auto guarded = [&](size_t i) {
+                try {
+                    task(i);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            };
+            std::vector<std::thread> threads;
+            threads.reserve(count - 1);
+            for (size_t i = 1; i < count; ++i) {
+                threads.emplace_back(guarded, i);
+            }
+            guarded(0);
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            for (auto& error : errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        }
+
+        // 依次解析 text 中的若干个值, 交给 sink(Node&&); 与串行解析一致, 值之间的逗号可以省略
+        // text 只含空白时返回 false, 空元素由调用者处理
+        template<typename Sink>
+        auto parse_values(std::string_view text, std::pmr::memory_resource* resource, size_t max_depth, Sink&& sink) -> bool {
+            const auto last = text.data() + text.size();
+            auto first = JsonScan::skip_whitespace(text.data(), last);
+            if (first == last) {
+                return false;
+            }
+            std::string scratch;
+            while (first != last) {
+                JsonParser::DomBuilder builder{resource};
+                JsonParser::SaxParser<JsonParser::DomBuilder> parser{{first, static_cast<size_t>(last - first)}, builder, max_depth,
+                                                                     nullptr, &scratch};
+                if (!parser.parse()) {
+                    return false;
+                }
+                sink(builder.take());
+                first = JsonScan::skip_whitespace(first + parser.position(), last);
+            }
+            return true;
+        }
+
+        // 依次解析对象成员 `"key": value`, 交给 sink(std::string&&, Node&&); 与串行解析一致, 逗号与冒号可以省略
+        template<typename Sink>
+        auto parse_members(std::string_view text, std::pmr::memory_resource* resource, size_t max_depth, Sink&& sink) -> bool {
+            const auto last = text.data() + text.size();
+            auto first = JsonScan::skip_whitespace(text.data(), last);
+            if (first == last) {
+                return false;
+            }
+            std::string scratch;
+            while (first != last) {
+                if (*first != '"') {
+                    return false;
+                }
+                bool escaped = false;
+                const auto close = JsonScan::scan_string(first + 1, last, escaped);
+                if (close == nullptr) {
+                    return false;
+                }
+                const auto decoded = JsonScan::decode_string({first + 1, static_cast<size_t>(close - first - 1)}, escaped, scratch);
+                if (!decoded) {
+                    return false;
+                }
+                if (decoded->size() > JsonNode::Key::max_size) {
+                    return false;
+                }
+                std::string key{*decoded};
+                first = JsonScan::skip_whitespace(close + 1, last);
+                if (first != last && *first == ':') {
+                    first = JsonScan::skip_whitespace(first + 1, last);
+                }
+                if (first == last) {
+                    return false;
+                }
+                JsonParser::DomBuilder builder{resource};
+                JsonParser::SaxParser<JsonParser::DomBuilder> parser{{first, static_cast<size_t>(last - first)}, builder, max_depth,
+                                                                     nullptr, &scratch};
+                if (!parser.parse()) {
+                    return false;
+                }
+                sink(std::move(key), builder.take());
+                first = JsonScan::skip_whitespace(first + parser.position(), last);
+            }
+            return true;
+        }
+
+        // 两阶段解析单个大文档: 第一阶段用向量化的分类器建立结构字符索引,
+        // 据此找出根数组/对象的顶层元素边界; 第二阶段把元素按字节数均分给各线程独立解析, 最后按顺序拼回根节点
+        // 根不是容器、输入太小或索引无法建立时退回串行解析; 接受的输入与串行解析完全相同(包括省略的逗号与冒号),
+        // 结果不取决于输入大小与线程数
+        inline auto parse(std::string_view text, const Options& options = {}) -> std::optional<Node> {
+            const auto serial = [&] {
+                JsonParser::Parser parser{text, options.resource};
+                parser.set_max_depth(options.max_depth);
+                return parser.parse();
+            };
+            const auto threads = options.threads != 0 ? options.threads : std::thread::hardware_concurrency();
+            if (text.size() < options.min_parallel_bytes || threads <= 1 || options.max_depth == 0) {
+                return serial();
+            }
+            std::vector<uint32_t> index;
+            if (!JsonScan::build_structural_index(text, index) || index.empty()) {
+                return serial();
+            }
+            const auto root_open = index.front();
+            const auto first = JsonScan::skip_whitespace(text.data(), text.data() + text.size());
+            if (static_cast<size_t>(first - text.data()) != root_open || (*first != '[' && *first != '{')) {
+                return serial();
+            }
+            const bool is_object = *first == '{';
+
+            // 顶层元素的分隔位置: 根的开括号、各个顶层逗号、根的闭括号
+            std::vector<uint32_t> separators{root_open};
+            size_t depth = 0;
+            bool closed = false;
+            for (size_t i = 0; i < index.size() && !closed; ++i) {
+                switch (text[index[i]]) {
+                    case '"': ++i; break;  // 引号成对出现, 跳过闭引号
+                    case '{': case '[': ++depth; break;
+                    case '}': case ']':
+                        if (--depth == 0) {
+                            separators.push_back(index[i]);
+                            closed = true;
+                        }
+                        break;
+                    case ',':
+                        if (depth == 1) {
+                            separators.push_back(index[i]);
+                        }
+                        break;
+                    default: break;
+                }
+            }
+            if (!closed || text[separators.back()] != (is_object ? '}' : ']')) {
+                return {};
+            }
+            const auto element = [&](size_t i) {
+                return text.substr(separators[i] + 1, separators[i + 1] - separators[i] - 1);
+            };
+
+            Node root{is_object ? JsonNode::ValueType{std::in_place_type<ObjectNode>, options.resource}
+                                : JsonNode::ValueType{std::in_place_type<ArrayNode>, options.resource}};
+            const auto count = separators.size() - 1;
+            const auto blank = [&](size_t i) {
+                const auto slice = element(i);
+                return JsonScan::skip_whitespace(slice.data(), slice.data() + slice.size()) == slice.data() + slice.size();
+            };
+            // 只有最后一个元素可以为空: 空容器, 或末尾多出的逗号
+            const auto elements = count > 0 && blank(count - 1) ? count - 1 : count;
+            if (elements == 0) {
+                return root;
+            }
+
+            // 按字节数把连续的元素分给各线程
+            const auto parts = std::min<size_t>(threads, elements);
+            std::vector<size_t> bounds{0};
+            const auto span = separators[elements] - separators.front();
+            for (size_t i = 0, part = 1; i < elements && part < parts; ++i) {
+                if (separators[i + 1] - separators.front() >= span * part / parts) {
+                    bounds.push_back(i + 1);
+                    ++part;
+                }
+            }
+            bounds.push_back(elements);
+
+            // 各线程按顺序收集自己负责的值; 省略逗号时一个元素区间中可能有多个值
+            std::vector<std::vector<Node>> values(bounds.size() - 1);
+            std::vector<std::vector<std::string>> keys(is_object ? bounds.size() - 1 : 0);
+            std::vector<char> failed(bounds.size() - 1, 0);
+            const auto depth_left = options.max_depth - 1;  // 根容器占一层
+            run_parallel(bounds.size() - 1, [&](size_t part) {
+                auto& part_values = values[part];
+                part_values.reserve(bounds[part + 1] - bounds[part]);
+                for (auto i = bounds[part]; i < bounds[part + 1]; ++i) {
+                    const bool ok = is_object
+                        ? parse_members(element(i), options.resource, depth_left, [&](std::string&& key, Node&& value) {
+                              keys[part].push_back(std::move(key));
+                              part_values.push_back(std::move(value));
+                          })
+                        : parse_values(element(i), options.resource, depth_left, [&](Node&& value) {
+                              part_values.push_back(std::move(value));
+                          });
+                    if (!ok) {
+                        failed[part] = 1;
+                        return;
+                    }
+                }
+            });
+            if (std::find(failed.begin(), failed.end(), 1) != failed.end()) {
+                return {};
+            }
+
+            if (auto object = root.get_if<ObjectNode>()) {
+                object->reserve(elements);
+                for (size_t part = 0; part < values.size(); ++part) {
+                    for (size_t j = 0; j < values[part].size(); ++j) {
+                        object->insert_or_assign(keys[part][j], std::move(values[part][j]));
+                    }
+                }
+            } else {
+                auto& array = *root.get_if<ArrayNode>();
+                array.reserve(elements);
+                for (auto& part_values : values) {
+                    std::move(part_values.begin(), part_values.end(), std::back_inserter(array));
+                }
+            }
+            return root;
+        }
+    }
+
+    namespace JsonLines {
+        using JsonNode::Node;
+
+        struct Options {
+            // 0 表示使用硬件线程数
+            size_t threads = 0;
+            // 有序回调模式下每一轮并行解析的输入字节数, 用来限制同时驻留的节点数
+            size_t round_bytes = 16 << 20;
+            // 输入小于该值时不值得开线程
+            size_t min_parallel_bytes = 64 << 10;
+            // 每个工作线程用一个驻留池共享各记录中重复的键, 适合键集合固定的数据
+            bool intern_keys = false;
+        };
+
+        struct Summary {
+            size_t records = 0;  // 成功解析的记录数
+            size_t errors = 0;   // 解析失败的记录数
+        };
+
+        // 一批记录的解析结果; 节点分配在各工作线程的 arena 上, 与 Batch 同生命周期
+        struct Batch {
+            // arenas 与 key_pools 必须先于 records 构造、晚于 records 析构
+            std::vector<std::unique_ptr<JsonMemory::Arena>> arenas;
+            // 仅在 intern_keys 时非空, 每个工作线程一个
+            std::vector<std::unique_ptr<JsonNode::KeyPool>> key_pools;
+            // 与输入中非空行一一对应, 解析失败的记录为空
+            std::vector<std::optional<Node>> records;
+        };
+
+        // 按行遍历, 跳过空行并去掉行尾的 `\r`; json 字符串里不会出现裸换行, 所以换行一定是记录边界
+        template<typename Visitor>
+        void for_each_line(std::string_view text, Visitor&& visitor) {
+            while (!text.empty()) {
+                const auto newline = text.find('\n');
+                auto line = text.substr(0, newline);
+                text = newline == std::string_view::npos ? std::string_view{} : text.substr(newline + 1);
+                if (!line.empty() && line.back() == '\r') {
+                    line.remove_suffix(1);
+                }
+                const auto first = JsonScan::skip_whitespace(line.data(), line.data() + line.size());
+                if (first != line.data() + line.size()) {
+                    visitor(line);
+                }
+            }
+        }
+
+        // 把输入切成大致等长、边界落在换行之后的若干段
+        inline auto split(std::string_view text, size_t parts) -> std::vector<std::string_view> {
+            std::vector<std::string_view> ranges;
+            parts = std::max<size_t>(parts, 1);
+            size_t begin = 0;
+            for (size_t i = 1; i <= parts && begin < text.size(); ++i) {
+                size_t end = i == parts ? text.size() : std::max(begin, text.size() * i / parts);
+                if (end < text.size()) {
+                    end = text.find('\n', end);
+                    end = end == std::string_view::npos ? text.size() : end + 1;
+                }
+                if (end > begin) {
+                    ranges.push_back(text.substr(begin, end - begin));
+                }
+                begin = end;
+            }
+            return ranges;
+        }
+
+        inline auto worker_count(std::string_view text, const Options& options) -> size_t {
+            if (text.size() < options.min_parallel_bytes) {
+                return 1;
+            }
+            const auto threads = options.threads != 0 ? options.threads : std::thread::hardware_concurrency();
+            return std::max<size_t>(threads, 1);
+        }
+
+        // 并行解析全部记录, 结果按输入顺序排列
+        // 每个工作线程复用一个解析器, 并把结果放在自己的 arena 上
+        inline auto parse(std::string_view text, const Options& options = {}) -> Batch {
+            const auto ranges = split(text, worker_count(text, options));
+            Batch batch;
+            std::vector<std::vector<std::optional<Node>>> parts(ranges.size());
+            for (size_t i = 0; i < ranges.size(); ++i) {
+                batch.arenas.push_back(std::make_unique<JsonMemory::Arena>(ranges[i].size() * 2));
+                if (options.intern_keys) {
+                    batch.key_pools.push_back(std::make_unique<JsonNode::KeyPool>());
+                }
+            }
+            JsonParallel::run_parallel(ranges.size(), [&](size_t i) {
+                JsonParser::Parser parser{std::string_view{}, batch.arenas[i].get()};
+                parser.set_key_pool(options.intern_keys ? batch.key_pools[i].get() : nullptr);
+                for_each_line(ranges[i], [&](std::string_view line) {
+                    parser.reset(line);
+                    parts[i].push_back(parser.parse());
+                });
+            });
+            size_t total = 0;
+            for (const auto& part : parts) {
+                total += part.size();
+            }
+            batch.records.reserve(total);
+            for (auto& part : parts) {
+                std::move(part.begin(), part.end(), std::back_inserter(batch.records));
+            }
+            return batch;
+        }
+
+        // 并行解析并在各工作线程上直接回调 callback(const Node&, std::string_view 记录原文)
+        // 回调顺序不确定, callback 必须线程安全; 节点只在回调期间有效
+        template<typename Callback>
+        auto for_each_unordered(std::string_view text, Callback&& callback, const Options& options = {}) -> Summary {
+            const auto ranges = split(text, worker_count(text, options));
+            std::vector<Summary> summaries(ranges.size());
+            JsonParallel::run_parallel(ranges.size(), [&](size_t i) {
+                JsonNode::KeyPool keys;
+                JsonParser::Parser parser;
+                parser.set_key_pool(options.intern_keys ? &keys : nullptr);
+                for_each_line(ranges[i], [&](std::string_view line) {
+                    parser.reset(line);
+                    if (auto node = parser.parse()) {
+                        ++summaries[i].records;
+                        callback(static_cast<const Node&>(*node), line);
+                    } else {
+                        ++summaries[i].errors;
+                    }
+                });
+            });
+            Summary summary;
+            for (const auto& part : summaries) {
+                summary.records += part.records;
+                summary.errors += part.errors;
+            }
+            return summary;
+        }
+
+        // 并行解析, 但在调用线程上按输入顺序回调 callback(const Node&, std::string_view 记录原文)
+        // 输入按 round_bytes 分轮处理, 同一时间只保留一轮的节点; 节点只在回调期间有效
+        template<typename Callback>
+        auto for_each(std::string_view text, Callback&& callback, const Options& options = {}) -> Summary {
+            Summary summary;
+            const auto workers = worker_count(text, options);
+            std::vector<std::unique_ptr<JsonMemory::Arena>> arenas;
+            // 驻留池跨轮保留, 后续各轮的键不再复制
+            std::vector<std::unique_ptr<JsonNode::KeyPool>> key_pools;
+            std::vector<std::vector<std::pair<std::optional<Node>, std::string_view>>> parts(workers);
+            for (size_t i = 0; i < workers; ++i) {
+                arenas.push_back(std::make_unique<JsonMemory::Arena>());
+                key_pools.push_back(options.intern_keys ? std::make_unique<JsonNode::KeyPool>() : nullptr);
+            }
+            while (!text.empty()) {
+                // 取出本轮的输入, 边界落在换行之后
+                auto end = std::min(text.size(), std::max<size_t>(options.round_bytes, 1));
+                if (end < text.size()) {
+                    end = text.find('\n', end);
+                    end = end == std::string_view::npos ? text.size() : end + 1;
+                }
+                const auto ranges = split(text.substr(0, end), workers);
+                text.remove_prefix(end);
+
+                JsonParallel::run_parallel(ranges.size(), [&](size_t i) {
+                    JsonParser::Parser parser{std::string_view{}, arenas[i].get()};
+                    parser.set_key_pool(key_pools[i].get());
+                    for_each_line(ranges[i], [&](std::string_view line) {
+                        parser.reset(line);
+                        parts[i].emplace_back(parser.parse(), line);
+                    });
+                });
+                for (size_t i = 0; i < ranges.size(); ++i) {
+                    for (const auto& [node, line] : parts[i]) {
+                        if (node) {
+                            ++summary.records;
+                            callback(*node, line);
+                        } else {
+                            ++summary.errors;
+                        }
+                    }
+                    parts[i].clear();
+                    arenas[i]->reset();
+                }
+            }
+            return summary;
+        }
+
+        // 映射文件后并行解析
+        inline auto parse_file(const std::filesystem::path& path, const Options& options = {}) -> std::optional<Batch> {
+            const auto file = JsonIO::MappedFile::open(path);
+            if (!file) {
+                return {};
+            }
+            return parse(file->view(), options);
+        }
+    }
+
+    namespace JsonSerializer {
+        using JsonNode::Node;
+        using JsonNode::ArrayNode, JsonNode::ObjectNode;
+        using JsonNode::MonoNode, JsonNode::ValueType, JsonNode::BoolNode, JsonNode::IntNode, JsonNode::FloatNode, JsonNode::StringNode;
+
+        // 输出目标: 只需支持写入单个字符与一段字符
+        template<typename Sink>
+        concept OutputSink = requires(Sink& sink, char ch, std::string_view str) {
+            sink.put(ch);
+            sink.write(str);
+        };
+
+        // 追加到调用者提供的可增长缓冲区
+        class StringSink {
+        protected:
+            std::string& buffer;
+        public:
+            explicit StringSink(std::string& buffer) : buffer(buffer) {}
+
+            void put(char ch) {
+                buffer.push_back(ch);
+            }
+            void write(std::string_view str) {
+                buffer.append(str);
+            }
+        };
+
+        // 写入 std::ostream, 内部攒满一块再交给流, 析构时自动刷新
+        class StreamSink {
+        protected:
+            static constexpr size_t capacity = 4096;
+
+            std::ostream& out;
+            size_t size = 0;
+            char buffer[capacity]{};
+        public:
+            explicit StreamSink(std::ostream& out) : out(out) {}
+            StreamSink(const StreamSink&) = delete;
+            auto operator=(const StreamSink&) -> StreamSink& = delete;
+            ~StreamSink() {
+                flush();
+            }
+
+            void put(char ch) {
+                if (size == capacity) {
+                    flush();
+                }
+                buffer[size++] = ch;
+            }
+            void write(std::string_view str) {
+                if (str.size() > capacity - size) {
+                    flush();
+                    if (str.size() > capacity) {
+                        out.write(str.data(), static_cast<std::streamsize>(str.size()));
+                        return;
+                    }
+                }
+                std::copy(str.begin(), str.end(), buffer + size);
+                size += str.size();
+            }
+            void flush() {
+                if (size != 0) {
+                    out.write(buffer, static_cast<std::streamsize>(size));
+                    size = 0;
+                }
+            }
+        };
+
+        // 写入固定长度的 char 缓冲区, 超出部分丢弃并记录溢出
+        class SpanSink {
+        protected:
+            char* data;
+            size_t capacity;
+            size_t written = 0;
+            size_t required = 0;
+        public:
+            SpanSink(char* data, size_t capacity) : data(data), capacity(capacity) {}
+
+            void put(char ch) {
+                if (written < capacity) {
+                    data[written++] = ch;
+                }
+                ++required;
+            }
+            void write(std::string_view str) {
+                const auto count = std::min(str.size(), capacity - written);
+                std::copy_n(str.data(), count, data + written);
+                written += count;
+                required += str.size();
+            }
+
+            // 实际写入的字节数
+            [[nodiscard]] auto size() const -> size_t {
+                return written;
+            }
+            // 完整输出所需的字节数, 溢出时可据此重新分配
+            [[nodiscard]] auto required_size() const -> size_t {
+                return required;
+            }
+            [[nodiscard]] auto overflow() const -> bool {
+                return required > capacity;
+            }
+        };
+
+        struct Options {
+            // 每层缩进的空格数, 0 表示紧凑输出
+            size_t indent = 0;
+            // 按键的字节序输出对象成员, 否则保持插入顺序
+            bool sort_keys = false;
+            // 非 ASCII 字符输出为 \uXXXX(必要时为代理对), 非法的 UTF-8 输出为 \ufffd
+            bool ascii_only = false;
+        };
+
+        // 只统计字节数的 sink, 用于预先计算输出大小
+        class CountingSink {
+        protected:
+            size_t count = 0;
+        public:
+            void put(char) { ++count; }
+            void write(std::string_view str) { count += str.size(); }
+            [[nodiscard]] auto size() const -> size_t { return count; }
+        };
+
+        // 转发给另一个 sink 并统计字节数
+        template<OutputSink Sink>
+        class MeteredSink {
+        protected:
+            Sink& sink;
+            size_t count = 0;
+        public:
+            explicit MeteredSink(Sink& sink) : sink(sink) {}
+            void put(char ch) {
+                ++count;
+                sink.put(ch);
+            }
+            void write(std::string_view str) {
+                count += str.size();
+                sink.write(str);
+            }
+            [[nodiscard]] auto size() const -> size_t { return count; }
+        };
+
+        // 序列化统计, 在多次输出之间累加
+        struct SerializeStats : JsonParser::ValueCounts {
+            size_t documents = 0;
+            size_t bytes = 0;         // 输出的字节数
+            size_t string_bytes = 0;  // 字符串与键转义前的字节数, 不含引号
+            size_t max_depth = 0;
+
+            auto operator+=(const SerializeStats& rhs) -> SerializeStats& {
+                ValueCounts::operator+=(rhs);
+                documents += rhs.documents;
+                bytes += rhs.bytes;
+                string_bytes += rhs.string_bytes;
+                max_depth = std::max(max_depth, rhs.max_depth);
+                return *this;
+            }
+        };
+
+        class Serializer {
+        protected:
+            // 正在输出的容器与下一个要输出的成员下标
+            struct Frame {
+                const ArrayNode* array;
+                const ObjectNode* object;
+                size_t next;
+                size_t order;  // sort_keys 时该对象排好序的成员在 State::order 中的起点
+            };
+            struct State {
+                const Options& options;
+                std::vector<Frame> stack;
+                // 各层对象排好序的成员指针, 与 stack 一起按栈的方式增减, 不为每个对象单独分配
+                std::vector<const ObjectNode::value_type*> order;
+                SerializeStats* stats = nullptr;
+
+                void count(size_t SerializeStats::* field, size_t amount = 1) const {
+                    if (stats) stats->*field += amount;
+                }
+                // 容器入栈之后调用
+                void count_container(size_t SerializeStats::* field) const {
+                    if (stats) {
+                        ++(stats->*field);
+                        stats->max_depth = std::max(stats->max_depth, stack.size());
+                    }
+                }
+            };
+
+            template<OutputSink Sink>
+            static void write_newline(Sink& sink, const State& state, size_t depth) {
+                if (state.options.indent == 0) {
+                    return;
+                }
+                static constexpr std::string_view spaces = "                                ";
+                sink.put('\n');
+                for (auto count = state.options.indent * depth; count != 0;) {
+                    const auto chunk = std::min(count, spaces.size());
+                    sink.write(spaces.substr(0, chunk));
+                    count -= chunk;
+                }
+            }
+
+            template<OutputSink Sink>
+            static void open_array(Sink& sink, const ArrayNode& array, State& state) {
+                sink.put('[');
+                state.stack.push_back({&array, nullptr, 0, 0});
+                state.count_container(&SerializeStats::arrays);
+                if (array.empty()) {
+                    state.stack.pop_back();
+                    sink.put(']');
+                }
+            }
+            template<OutputSink Sink>
+            static void open_object(Sink& sink, const ObjectNode& object, State& state) {
+                sink.put('{');
+                if (object.empty()) {
+                    state.stack.push_back({nullptr, &object, 0, 0});
+                    state.count_container(&SerializeStats::objects);
+                    state.stack.pop_back();
+                    sink.put('}');
+                    return;
+                }
+                const auto order = state.order.size();
+                if (state.options.sort_keys) {
+                    for (const auto& member : object) {
+                        state.order.push_back(&member);
+                    }
+                    std::sort(state.order.begin() + static_cast<std::ptrdiff_t>(order), state.order.end(),
+                              [](const auto* lhs, const auto* rhs) { return lhs->first.view() < rhs->first.view(); });
+                }
+                state.stack.push_back({nullptr, &object, 0, order});
+                state.count_container(&SerializeStats::objects);
+            }
+
+            // 紧凑数组不入栈, 一次输出完: 数字先批量格式化到栈上的缓冲区, 每 4KB 左右才写一次 sink
+            template<OutputSink Sink, typename Number>
+            static void write_packed(Sink& sink, const std::pmr::vector<Number>& numbers, State& state) {
+                state.stack.push_back({nullptr, nullptr, 0, 0});
+                state.count_container(&SerializeStats::arrays);
+                state.count(std::is_same_v<Number, IntNode> ? &SerializeStats::integers : &SerializeStats::floats, numbers.size());
+                const auto depth = state.stack.size();
+                state.stack.pop_back();
+                sink.put('[');
+                if (numbers.empty()) {
+                    sink.put(']');
+                    return;
+                }
+                char buffer[4096];
+                char* cursor = buffer;
+                const auto flush = [&] {
+                    sink.write({buffer, static_cast<size_t>(cursor - buffer)});
+                    cursor = buffer;
+                };
+                for (size_t i = 0; i < numbers.size(); ++i) {
+                    if (state.options.indent != 0) {
+                        if (i != 0) *cursor++ = ',';
+                        flush();
+                        write_newline(sink, state, depth);
+                    } else {
+                        if (buffer + sizeof buffer - cursor < static_cast<std::ptrdiff_t>(max_number_size + 1)) flush();
+                        if (i != 0) *cursor++ = ',';
+                    }
+                    if constexpr (std::is_same_v<Number, IntNode>) {
+                        cursor = format_int(cursor, numbers[i]);
+                    } else {
+                        cursor = format_float(cursor, numbers[i]);
+                    }
+                }
+                flush();
+                write_newline(sink, state, depth - 1);
+                sink.put(']');
+            }
+
+            // 输出一个值; 非空容器只写开括号并入栈, 成员由 write_frames 继续输出
+            template<OutputSink Sink>
+            static void write_value(Sink& sink, const Node& node, State& state) {
+                std::visit(
+                    [&]<typename T0>(const T0 &arg) {
+                        using T = std::decay_t<T0>;
+                        if constexpr (std::is_same_v<T, MonoNode>) {
+                            state.count(&SerializeStats::nulls);
+                            sink.write("null");
+                        } else if constexpr (std::is_same_v<T, BoolNode>) {
+                            state.count(&SerializeStats::bools);
+                            sink.write(arg ? "true" : "false");
+                        } else if constexpr (std::is_same_v<T, IntNode>) {
+                            state.count(&SerializeStats::integers);
+                            write_int(sink, arg);
+                        } else if constexpr (std::is_same_v<T, FloatNode>) {
+                            state.count(&SerializeStats::floats);
+                            write_float(sink, arg);
+                        } else if constexpr (std::is_same_v<T, StringNode>) {
+                            state.count(&SerializeStats::strings);
+                            state.count(&SerializeStats::string_bytes, arg.size());
+                            write_string(sink, arg, state.options.ascii_only);
+                        } else if constexpr (std::is_same_v<T, ArrayNode>) {
+                            open_array(sink, arg, state);
+                        } else if constexpr (std::is_same_v<T, ObjectNode>) {
+                            open_object(sink, arg, state);
+                        } else if constexpr (std::is_same_v<T, JsonNode::Int64Array> || std::is_same_v<T, JsonNode::DoubleArray>) {
+                            write_packed(sink, arg, state);
+                        }
+                    },
+                    node.Value());
+            }
+
+            // 输出栈顶容器的下一个成员, 或在成员输出完时关闭它; 栈不能为空
+            template<OutputSink Sink>
+            static void write_step(Sink& sink, State& state) {
+                auto& stack = state.stack;
+                auto& frame = stack.back();
+                const auto size = frame.array ? frame.array->size() : frame.object->size();
+                if (frame.next == size) {
+                    const bool is_array = frame.array != nullptr;
+                    if (!is_array && state.options.sort_keys) {
+                        state.order.resize(frame.order);
+                    }
+                    stack.pop_back();
+                    write_newline(sink, state, stack.size());
+                    sink.put(is_array ? ']' : '}');
+                    return;
+                }
+                if (frame.next != 0) sink.put(',');
+                write_newline(sink, state, stack.size());
+                const auto index = frame.next++;
+                if (frame.array) {
+                    write_value(sink, (*frame.array)[index], state);  // 可能使 frame 失效
+                } else {
+                    const auto& [key, node] = state.options.sort_keys
+                                                  ? *state.order[frame.order + index]
+                                                  : *(frame.object->begin() + static_cast<std::ptrdiff_t>(index));
+                    state.count(&SerializeStats::keys);
+                    state.count(&SerializeStats::string_bytes, key.size());
+                    write_string(sink, key, state.options.ascii_only);
+                    sink.put(':');
+                    if (state.options.indent != 0) sink.put(' ');
+                    write_value(sink, node, state);
+                }
+            }
+
+            // 用显式栈代替递归, 调用栈的深度与树的嵌套层数无关
+            template<OutputSink Sink>
+            static void write_frames(Sink& sink, State& state) {
+                while (!state.stack.empty()) {
+                    write_step(sink, state);
+                }
+            }
+
+            template<OutputSink Sink>
+            static void write_code_unit(Sink& sink, uint32_t unit) {
+                constexpr char hex[] = "0123456789abcdef";
+                const char escape[] = {'\\', 'u', hex[unit >> 12 & 0xf], hex[unit >> 8 & 0xf], hex[unit >> 4 & 0xf], hex[unit & 0xf]};
+                sink.write({escape, sizeof escape});
+            }
+            // 把 first 处的 UTF-8 序列输出为 \uXXXX, 返回序列之后的位置
+            template<OutputSink Sink>
+            static auto write_non_ascii(Sink& sink, const char* first, const char* last) -> const char* {
+                const auto lead = static_cast<unsigned char>(*first);
+                const size_t length = lead >= 0xf0 ? 4 : lead >= 0xe0 ? 3 : lead >= 0xc0 ? 2 : 0;
+                uint32_t code_point = length == 4 ? lead & 0x07u : length == 3 ? lead & 0x0fu : lead & 0x1fu;
+                bool valid = length != 0 && lead < 0xf5 && static_cast<size_t>(last - first) >= length;
+                for (size_t i = 1; valid && i < length; ++i) {
+                    const auto byte = static_cast<unsigned char>(first[i]);
+                    valid = (byte & 0xc0) == 0x80;
+                    code_point = code_point << 6 | (byte & 0x3fu);
+                }
+                constexpr uint32_t minimum[] = {0, 0, 0x80, 0x800, 0x10000};
+                if (!valid || code_point < minimum[length] || code_point > 0x10ffff || (code_point >= 0xd800 && code_point <= 0xdfff)) {
+                    write_code_unit(sink, 0xfffd);
+                    return first + 1;
+                }
+                if (code_point >= 0x10000) {
+                    code_point -= 0x10000;
+                    write_code_unit(sink, 0xd800 + (code_point >> 10));
+                    write_code_unit(sink, 0xdc00 + (code_point & 0x3ff));
+                } else {
+                    write_code_unit(sink, code_point);
+                }
+                return first + length;
+            }
+        public:
+            // 将节点直接写入 sink, 整个过程不产生中间字符串
+            // stats 非空时把统计累加进去
+            template<OutputSink Sink>
+            static void write(Sink& sink, const Node& node, const Options& options = {}, SerializeStats* stats = nullptr) {
+                if (stats) {
+                    MeteredSink<Sink> metered{sink};
+                    State state{options, {}, {}, stats};
+                    write_value(metered, node, state);
+                    write_frames(metered, state);
+                    ++stats->documents;
+                    stats->bytes += metered.size();
+                    return;
+                }
+                State state{options, {}, {}};
+                write_value(sink, node, state);
+                write_frames(sink, state);
+            }
+            // 按 options 输出时的确切字节数, 用于一次性预留缓冲区
+            static auto serialized_size(const Node& node, const Options& options = {}) -> size_t {
+                CountingSink sink;
+                write(sink, node, options);
+                return sink.size();
+            }
+            // 以下 format_* 把数字写到 out 开始的缓冲区并返回末尾, 缓冲区至少要有 max_number_size 字节
+            static constexpr size_t max_number_size = 32;
+            static auto format_int(char* out, IntNode number) -> char* {
+                return std::to_chars(out, out + max_number_size, number).ptr;
+            }
+            // 输出能精确还原的最短表示; 没有小数点和指数时补上 `.0`, 保证重新解析后仍是浮点数
+            // json 无法表示 inf 与 nan, 输出为 null
+            static auto format_float(char* out, FloatNode number) -> char* {
+                if (!std::isfinite(number)) {
+                    return std::copy_n("null", 4, out);
+                }
+                auto end = std::to_chars(out, out + max_number_size - 2, number).ptr;
+                if (std::find_if(out, end, [](char ch) { return ch == '.' || ch == 'e'; }) == end) {
+                    *end++ = '.';
+                    *end++ = '0';
+                }
+                return end;
+            }
+            template<OutputSink Sink>
+            static void write_int(Sink& sink, IntNode number) {
+                char buffer[max_number_size];
+                const auto end = format_int(buffer, number);
+                sink.write({buffer, static_cast<size_t>(end - buffer)});
+            }
+            template<OutputSink Sink>
+            static void write_float(Sink& sink, FloatNode number) {
+                char buffer[max_number_size];
+                const auto end = format_float(buffer, number);
+                sink.write({buffer, static_cast<size_t>(end - buffer)});
+            }
+            // 不需要转义的片段整段写出, 只在 `"`、`\` 与控制字符处停下(ascii_only 时还有非 ASCII 字符)
+            template<OutputSink Sink>
+            static void write_string(Sink& sink, std::string_view str, bool ascii_only = false) {
+                sink.put('"');
+                auto first = str.data();
+                const auto last = first + str.size();
+                while (true) {
+                    const auto hit = ascii_only ? JsonScan::find_escapable_ascii(first, last) : JsonScan::find_escapable(first, last);
+                    if (hit != first) {
+                        sink.write({first, static_cast<size_t>(hit - first)});
+                    }
+                    if (hit == last) {
+                        break;
+                    }
+                    if (static_cast<unsigned char>(*hit) >= 0x80) {
+                        first = write_non_ascii(sink, hit, last);
+                        continue;
+                    }
+                    write_escape(sink, *hit);
+                    first = hit + 1;
+                }
+                sink.put('"');
+            }
+            template<OutputSink Sink>
+            static void write_escape(Sink& sink, char ch) {
+                switch (ch) {
+                    case '"': sink.write("\\\""); return;
+                    case '\\': sink.write("\\\\"); return;
+                    case '\b': sink.write("\\b"); return;
+                    case '\f': sink.write("\\f"); return;
+                    case '\n': sink.write("\\n"); return;
+                    case '\r': sink.write("\\r"); return;
+                    case '\t': sink.write("\\t"); return;
+                    default: {
+                        constexpr char hex[] = "0123456789abcdef";
+                        const auto code = static_cast<unsigned char>(ch);
+                        const char escape[] = {'\\', 'u', '0', '0', hex[code >> 4], hex[code & 0xf]};
+                        sink.write({escape, sizeof escape});
+                        return;
+                    }
+                }
+            }
+            template<OutputSink Sink>
+            static void write_array(Sink& sink, const ArrayNode& array, const Options& options = {}) {
+                State state{options, {}, {}};
+                open_array(sink, array, state);
+                write_frames(sink, state);
+            }
+            template<OutputSink Sink>
+            static void write_object(Sink& sink, const ObjectNode& object, const Options& options = {}) {
+                State state{options, {}, {}};
+                open_object(sink, object, state);
+                write_frames(sink, state);
+            }
+
+            static auto generate(const Node &node) -> std::string {
+                std::string json_str;
+                StringSink sink{json_str};
+                write(sink, node);
+                return json_str;
+            }
+            // 先计算确切大小再输出, 整个结果只分配一次
+            static auto generate(const Node& node, const Options& options) -> std::string {
+                std::string json_str;
+                json_str.reserve(serialized_size(node, options));
+                StringSink sink{json_str};
+                write(sink, node, options);
+                return json_str;
+            }
+            static auto generate_string(const StringNode& str) -> std::string {
+                std::string json_str;
+                StringSink sink{json_str};
+                write_string(sink, str);
+                return json_str;
+            }
+            static auto generate_array(const ArrayNode& array) -> std::string {
+                std::string json_str;
+                StringSink sink{json_str};
+                write_array(sink, array);
+                return json_str;
+            }
+            static auto generate_object(const ObjectNode& object) -> std::string {
+                std::string json_str;
+                StringSink sink{json_str};
+                write_object(sink, object);
+                return json_str;
+            }
+        };
+
+        // 可以分段进行的序列化: 每次 pump 输出大约 budget 字节后停下, 下次从停下的地方继续
+        // 用于边写边发送的场景, 不需要先生成完整的字符串; node 在输出完之前必须保持不变
+        class ChunkedWriter : protected Serializer {
+        protected:
+            Options options;
+            State state;
+            const Node* root;
+            bool started = false;
+        public:
+            explicit ChunkedWriter(const Node& node, const Options& options = {})
+                : options(options), state{this->options, {}, {}}, root(&node) {}
+            // state 引用自身的 options, 不能复制或移动
+            ChunkedWriter(const ChunkedWriter&) = delete;
+            auto operator=(const ChunkedWriter&) -> ChunkedWriter& = delete;
+
+            // 向 out 追加输出, 直到 out 的长度不小于 budget 或全部输出完; 返回是否已经全部输出
+            // 单个字符串不会被切开, 所以 out 可能略超过 budget
+            auto pump(std::string& out, size_t budget) -> bool {
+                StringSink sink{out};
+                if (!started) {
+                    started = true;
+                    write_value(sink, *root, state);
+                }
+                while (!state.stack.empty() && out.size() < budget) {
+                    write_step(sink, state);
+                }
+                return done();
+            }
+            [[nodiscard]] auto done() const -> bool {
+                return started && state.stack.empty();
+            }
+        };
+
+        // 把 SAX 事件直接输出成紧凑的 json, 用于不经过 Node 的序列化(磁带、共享树); 事件必须构成合法的文档
+        template<OutputSink Sink>
+        class SaxWriter {
+        protected:
+            Sink& sink;
+            bool comma = false;  // 下一个值或键之前需要逗号
+
+            void separate() {
+                if (comma) sink.put(',');
+            }
+        public:
+            explicit SaxWriter(Sink& sink) : sink(sink) {}
+
+            auto on_null() -> bool { separate(); sink.write("null"); comma = true; return true; }
+            auto on_bool(BoolNode value) -> bool { separate(); sink.write(value ? "true" : "false"); comma = true; return true; }
+            auto on_int(IntNode value) -> bool { separate(); Serializer::write_int(sink, value); comma = true; return true; }
+            auto on_double(FloatNode value) -> bool { separate(); Serializer::write_float(sink, value); comma = true; return true; }
+            auto on_string(std::string_view value) -> bool {
+                separate();
+                Serializer::write_string(sink, value);
+                comma = true;
+                return true;
+            }
+            auto key(std::string_view name) -> bool {
+                separate();
+                Serializer::write_string(sink, name);
+                sink.put(':');
+                comma = false;
+                return true;
+            }
+            auto start_object() -> bool { separate(); sink.put('{'); comma = false; return true; }
+            auto end_object() -> bool { sink.put('}'); comma = true; return true; }
+            auto start_array() -> bool { separate(); sink.put('['); comma = false; return true; }
+            auto end_array() -> bool { sink.put(']'); comma = true; return true; }
+        };
+    }
+
+    namespace JsonTape {
+        using JsonNode::Node;
+        using JsonNode::ArrayNode, JsonNode::ObjectNode;
+        using JsonNode::MonoNode, JsonNode::BoolNode, JsonNode::IntNode, JsonNode::FloatNode, JsonNode::StringNode;
+        using JsonOnDemand::Type;
+
+        class Value;
+        class Image;
+
+        // 紧凑的只读文档: 所有值按文档顺序排在一条 uint64_t 磁带上, 字符串另存在一块连续缓冲区里
+        // 每个词条的高 8 位是类型标记, 低 56 位是负载:
+        //   'n' 't' 'f'      null/true/false, 占 1 个词条
+        //   'l' 'd'          int64/double, 数值放在紧随其后的词条中, 占 2 个词条
+        //   '"'              字符串(对象的键也是), 负载为字符串缓冲区中的偏移, 该处先存 4 字节长度
+        //   '[' '{'          容器开始, 低 32 位为容器结束后的下一个词条, 32..55 位为元素个数(超过 2^24-1 时饱和)
+        //   ']' '}'          容器结束, 负载为对应开始词条的位置
+        // 对象的成员依次存为键、值; 跳过任何子树都只需一次读取
+        //
+        // 二进制镜像(to_binary/save)就是这两块内存加一个文件头, 按本机字节序存放:
+        //   [0, 8)    magic "JSONTAPE"
+        //   [8, 12)   版本号
+        //   [12, 16)  字节序标记 0x01020304, 用来拒绝其他字节序的机器写出的文件
+        //   [16, 24)  词条个数
+        //   [24, 32)  字符串缓冲区字节数
+        //   之后依次是磁带与字符串缓冲区; 文件头为 32 字节, 所以磁带在映射的内存中天然 8 字节对齐
+        // Image 把这样的文件映射进内存后原地遍历, 不需要解码
+
+        inline constexpr uint64_t payload_mask = (uint64_t{1} << 56) - 1;
+        inline constexpr uint64_t count_limit = (uint64_t{1} << 24) - 1;
+        // 容器的结束位置与字符串长度都只有 32 位, 超出时 parse/from_node 失败而不是写出截断的词条
+        inline constexpr uint64_t word_limit = UINT32_MAX;
+
+        constexpr auto make(char tag, uint64_t payload = 0) -> uint64_t {
+            return static_cast<uint64_t>(static_cast<uint8_t>(tag)) << 56 | (payload & payload_mask);
+        }
+        constexpr auto tag_of(uint64_t word) -> char {
+            return static_cast<char>(word >> 56);
+        }
+        constexpr auto payload_of(uint64_t word) -> uint64_t {
+            return word & payload_mask;
+        }
+
+        // 磁带与字符串缓冲区的只读视图, 存储可以属于 Tape, 也可以是映射进来的二进制镜像
+        struct View {
+            std::span<const uint64_t> words;
+            std::span<const char> strings;
+
+            // 词条 index 之后下一个兄弟值的位置
+            [[nodiscard]] auto next(size_t index) const -> size_t {
+                const auto word = words[index];
+                switch (tag_of(word)) {
+                    case '[': case '{': return static_cast<size_t>(payload_of(word) & 0xffffffffu);
+                    case 'l': case 'd': return index + 2;
+                    default: return index + 1;
+                }
+            }
+            [[nodiscard]] auto string_at(uint64_t offset) const -> std::string_view {
+                uint32_t length = 0;
+                std::copy_n(strings.data() + offset, sizeof length, reinterpret_cast<char*>(&length));
+                return {strings.data() + offset + sizeof length, length};
+            }
+
+            // 检查磁带结构完整: 标记合法, 容器首尾互相对应, 对象的键都是字符串, 字符串不越界
+            // 来自文件的镜像在原地遍历之前必须通过检查, 之后的访问都不会越界
+            // 容器嵌套超过 max_depth 层的镜像同样被拒绝, 与解析器的深度限制一致
+            [[nodiscard]] auto validate(size_t max_depth = JsonParser::default_max_depth) const -> bool;
+        };
+
+        class Tape {
+            friend class Builder;
+        public:
+            static constexpr uint64_t payload_mask = JsonTape::payload_mask;
+            static constexpr uint64_t count_limit = JsonTape::count_limit;
+            static constexpr uint64_t word_limit = JsonTape::word_limit;
+
+            static constexpr auto make(char tag, uint64_t payload = 0) -> uint64_t {
+                return JsonTape::make(tag, payload);
+            }
+            static constexpr auto tag_of(uint64_t word) -> char {
+                return JsonTape::tag_of(word);
+            }
+            static constexpr auto payload_of(uint64_t word) -> uint64_t {
+                return JsonTape::payload_of(word);
+            }
+
+            static constexpr std::string_view magic = "JSONTAPE";
+            static constexpr uint32_t version = 1;
+            static constexpr uint32_t byte_order = 0x01020304;
+            static constexpr size_t header_size = 32;
+        protected:
+            std::vector<uint64_t> words;
+            std::vector<char> strings;
+        public:
+            Tape() = default;
+
+            // 解析失败时返回空
+            static auto parse(std::string_view json_str) -> std::optional<Tape>;
+            // 把已有的树压缩成磁带, 用于长期缓存的文档; 磁带超出 32 位的范围时返回空
+            static auto from_node(const Node& node) -> std::optional<Tape>;
+            // 从 to_binary 的结果复制出磁带; 格式、版本、字节序不对, 结构检查失败或嵌套超过 max_depth 层时返回空
+            static auto from_binary(std::string_view bytes, size_t max_depth = JsonParser::default_max_depth) -> std::optional<Tape>;
+
+            // 二进制镜像, 格式见上
+            [[nodiscard]] auto to_binary() const -> std::string;
+            // 写入文件, 之后可以用 Image::open 映射
+            auto save(const std::filesystem::path& path) const -> bool;
+
+            [[nodiscard]] auto root() const -> Value;
+            [[nodiscard]] auto view() const -> View { return {words, strings}; }
+            [[nodiscard]] auto empty() const -> bool { return words.empty(); }
+
+            // 磁带与字符串缓冲区实际占用的字节数
+            [[nodiscard]] auto memory_usage() const -> size_t {
+                return words.size() * sizeof(uint64_t) + strings.size();
+            }
+            [[nodiscard]] auto tape() const -> const std::vector<uint64_t>& { return words; }
+            [[nodiscard]] auto string_buffer() const -> const std::vector<char>& { return strings; }
+
+            [[nodiscard]] auto next(size_t index) const -> size_t {
+                return view().next(index);
+            }
+            [[nodiscard]] auto string_at(uint64_t offset) const -> std::string_view {
+                return view().string_at(offset);
+            }
+        };
+
+        // 生成磁带的 SAX handler
+        class Builder {
+        protected:
+            Tape& tape;
+            struct Open {
+                size_t start;
+                uint64_t count;
+                bool is_object;
+            };
+            std::vector<Open> open;
+
+            void push(char tag, uint64_t payload = 0) {
+                tape.words.push_back(Tape::make(tag, payload));
+            }
+            // 数组元素在值上计数, 对象成员在键上计数
+            void add_value() {
+                if (!open.empty() && !open.back().is_object) {
+                    ++open.back().count;
+                }
+            }
+            auto push_string(char tag, std::string_view str) -> bool {
+                if (str.size() > Tape::word_limit) {
+                    return false;  // 长度前缀只有 32 位
+                }
+                const auto offset = tape.strings.size();
+                const auto length = static_cast<uint32_t>(str.size());
+                tape.strings.insert(tape.strings.end(), reinterpret_cast<const char*>(&length),
+                                    reinterpret_cast<const char*>(&length) + sizeof length);
+                tape.strings.insert(tape.strings.end(), str.begin(), str.end());
+                push(tag, offset);
+                return true;
+            }
+            auto start(bool is_object) -> bool {
+                add_value();
+                open.push_back({tape.words.size(), 0, is_object});
+                push(is_object ? '{' : '[');
+                return true;
+            }
+            // 结束位置写不进开始词条的低 32 位时失败; 外层容器结束得更晚, 所以只需在这里检查
+            auto end(bool is_object) -> bool {
+                const auto [start, count, _] = open.back();
+                open.pop_back();
+                push(is_object ? '}' : ']', start);
+                const auto after = static_cast<uint64_t>(tape.words.size());
+                if (after > Tape::word_limit) {
+                    return false;
+                }
+                tape.words[start] = Tape::make(is_object ? '{' : '[', after | std::min<uint64_t>(count, Tape::count_limit) << 32);
+                return true;
+            }
+        public:
+            explicit Builder(Tape& tape) : tape(tape) {}
+
+            auto on_null() -> bool {
+                add_value();
+                push('n');
+                return true;
+            }
+            auto on_bool(BoolNode value) -> bool {
+                add_value();
+                push(value ? 't' : 'f');
+                return true;
+            }
+            auto on_int(IntNode value) -> bool {
+                add_value();
+                push('l');
+                tape.words.push_back(static_cast<uint64_t>(value));
+                return true;
+            }
+            auto on_double(FloatNode value) -> bool {
+                add_value();
+                push('d');
+                tape.words.push_back(std::bit_cast<uint64_t>(value));
+                return true;
+            }
+            auto on_string(std::string_view value) -> bool {
+                add_value();
+                return push_string('"', value);
+            }
+            auto key(std::string_view name) -> bool {
+                ++open.back().count;
+                return push_string('"', name);
+            }
+            auto start_object() -> bool { return start(true); }
+            auto end_object() -> bool { return end(true); }
+            auto start_array() -> bool { return start(false); }
+            auto end_array() -> bool { return end(false); }
+
+            // 按树的结构依次产生事件, 磁带超出 32 位的范围时返回 false
+            auto visit(const Node& root) -> bool {
+                return JsonParser::replay(root, *this);
+            }
+        };
+
+        // 磁带上某个值的句柄, 接口与 JsonOnDemand::Value 一致; 只在 Tape(或 Image) 存活且未被修改时有效
+        class Value {
+        protected:
+            View tape;
+            size_t index = 0;
+
+            [[nodiscard]] auto word() const -> uint64_t { return tape.words[index]; }
+            [[nodiscard]] auto tag() const -> char { return Tape::tag_of(word()); }
+        public:
+            Value() = default;
+            Value(View tape, size_t index) : tape(tape), index(index) {}
+            Value(const Tape& tape, size_t index) : tape(tape.view()), index(index) {}
+
+            [[nodiscard]] auto position() const -> size_t { return index; }
+
+            [[nodiscard]] auto type() const -> Type {
+                if (index >= tape.words.size()) {
+                    return Type::Invalid;
+                }
+                switch (tag()) {
+                    case 'n': return Type::Null;
+                    case 't': case 'f': return Type::Bool;
+                    case 'l': case 'd': return Type::Number;
+                    case '"': return Type::String;
+                    case '[': return Type::Array;
+                    case '{': return Type::Object;
+                    default: return Type::Invalid;
+                }
+            }
+            [[nodiscard]] auto is_null() const -> bool { return type() == Type::Null; }
+
+            // 支持 BoolNode, IntNode, FloatNode 与 std::string_view(指向磁带的字符串缓冲区)
+            // 整数也可以按 FloatNode 读取
+            template<typename Ty>
+            [[nodiscard]] auto as() const -> std::optional<Ty> {
+                const auto kind = type();
+                if constexpr (std::is_same_v<Ty, BoolNode>) {
+                    if (kind != Type::Bool) return {};
+                    return tag() == 't';
+                } else if constexpr (std::is_same_v<Ty, IntNode>) {
+                    if (kind != Type::Number || tag() != 'l') return {};
+                    return static_cast<IntNode>(tape.words[index + 1]);
+                } else if constexpr (std::is_same_v<Ty, FloatNode>) {
+                    if (kind != Type::Number) return {};
+                    const auto bits = tape.words[index + 1];
+                    return tag() == 'd' ? std::bit_cast<FloatNode>(bits) : static_cast<FloatNode>(static_cast<IntNode>(bits));
+                } else if constexpr (std::is_same_v<Ty, std::string_view>) {
+                    if (kind != Type::String) return {};
+                    return tape.string_at(Tape::payload_of(word()));
+                } else {
+                    static_assert(!sizeof(Ty), "unsupported tape type");
+                }
+            }
+
+            // 数组的元素个数或对象的成员个数, 不需要遍历
+            [[nodiscard]] auto size() const -> size_t {
+                const auto kind = type();
+                if (kind != Type::Array && kind != Type::Object) return 0;
+                const auto count = Tape::payload_of(word()) >> 32;
+                if (count < Tape::count_limit) return count;
+                size_t total = 0;
+                for (auto i = index + 1; Tape::tag_of(tape.words[i]) != (kind == Type::Array ? ']' : '}');
+                     i = tape.next(kind == Type::Array ? i : i + 1)) {
+                    ++total;
+                }
+                return total;
+            }
+
+            // 第 position 个数组元素
+            [[nodiscard]] auto at(size_t position) const -> std::optional<Value> {
+                if (type() != Type::Array) return {};
+                for (auto i = index + 1; Tape::tag_of(tape.words[i]) != ']'; i = tape.next(i)) {
+                    if (position-- == 0) return Value{tape, i};
+                }
+                return {};
+            }
+            [[nodiscard]] auto find(std::string_view key) const -> std::optional<Value> {
+                if (type() != Type::Object) return {};
+                for (auto i = index + 1; Tape::tag_of(tape.words[i]) != '}'; i = tape.next(i + 1)) {
+                    if (tape.string_at(Tape::payload_of(tape.words[i])) == key) return Value{tape, i + 1};
+                }
+                return {};
+            }
+            [[nodiscard]] auto operator[](std::string_view key) const -> std::optional<Value> {
+                return find(key);
+            }
+
+            // 依次访问数组元素 visitor(Value) 或对象成员 visitor(std::string_view, Value)
+            template<typename Visitor>
+            void for_each_element(Visitor&& visitor) const {
+                if (type() != Type::Array) return;
+                for (auto i = index + 1; Tape::tag_of(tape.words[i]) != ']'; i = tape.next(i)) {
+                    visitor(Value{tape, i});
+                }
+            }
+            template<typename Visitor>
+            void for_each_field(Visitor&& visitor) const {
+                if (type() != Type::Object) return;
+                for (auto i = index + 1; Tape::tag_of(tape.words[i]) != '}'; i = tape.next(i + 1)) {
+                    visitor(tape.string_at(Tape::payload_of(tape.words[i])), Value{tape, i + 1});
+                }
+            }
+
+            // 按文档顺序把这个值作为 SAX 事件交给 handler, 事件与 parse_sax 对同一文本产生的一致
+            // 线性扫描词条, 只用一个位栈记录所在容器是不是对象, 嵌套多深都不会递归; handler 返回 false 时停止并返回 false
+            template<JsonParser::SaxHandler Handler>
+            auto replay(Handler& handler) const -> bool {
+                if (type() == Type::Invalid) {
+                    return false;
+                }
+                JsonParser::ContainerStack stack;
+                bool at_key = false;  // 下一个字符串词条是对象的键
+                const auto end = tape.next(index);
+                for (auto i = index; i < end;) {
+                    const auto word = tape.words[i];
+                    bool ok = true;
+                    switch (Tape::tag_of(word)) {
+                        case 'n': ok = handler.on_null(); break;
+                        case 't': ok = handler.on_bool(true); break;
+                        case 'f': ok = handler.on_bool(false); break;
+                        case 'l': ok = handler.on_int(static_cast<IntNode>(tape.words[i + 1])); break;
+                        case 'd': ok = handler.on_double(std::bit_cast<FloatNode>(tape.words[i + 1])); break;
+                        case '"': {
+                            const auto str = tape.string_at(Tape::payload_of(word));
+                            ok = at_key ? handler.key(str) : handler.on_string(str);
+                            break;
+                        }
+                        case '[': ok = handler.start_array(); stack.push(false); break;
+                        case '{': ok = handler.start_object(); stack.push(true); break;
+                        case ']': ok = handler.end_array(); stack.pop(); break;
+                        case '}': ok = handler.end_object(); stack.pop(); break;
+                        default: return false;
+                    }
+                    if (!ok) {
+                        return false;
+                    }
+                    const auto tag = Tape::tag_of(word);
+                    // 键之后是值; 其他词条之后, 所在容器是对象时轮到下一个键
+                    at_key = tag == '{' || (!(at_key && tag == '"') && tag != '[' && !stack.empty() && stack.top());
+                    i = tag == 'l' || tag == 'd' ? i + 2 : i + 1;
+                }
+                return true;
+            }
+
+            // 需要修改时展开成 Node; 重复的键沿用第一次出现的位置, 值取最后一次的
+            [[nodiscard]] auto to_node(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const -> Node {
+                JsonParser::DomBuilder builder{resource};
+                if (!replay(builder)) {
+                    return Node{};
+                }
+                return builder.take();
+            }
+
+            // 直接从磁带序列化, 不展开成 Node
+            template<JsonSerializer::OutputSink Sink>
+            void write(Sink& sink) const {
+                JsonSerializer::SaxWriter writer{sink};
+                replay(writer);
+            }
+            [[nodiscard]] auto to_str() const -> std::string {
+                std::string json_str;
+                JsonSerializer::StringSink sink{json_str};
+                write(sink);
+                return json_str;
+            }
+        };
+
+        inline auto Tape::parse(std::string_view json_str) -> std::optional<Tape> {
+            Tape tape;
+            // 粗略预估, 避免小文档反复扩容
+            tape.words.reserve(json_str.size() / 4 + 4);
+            tape.strings.reserve(json_str.size() / 2);
+            Builder builder{tape};
+            if (!JsonParser::parse_sax(json_str, builder)) {
+                return {};
+            }
+            tape.words.shrink_to_fit();
+            tape.strings.shrink_to_fit();
+            return tape;
+        }
+
+        inline auto Tape::from_node(const Node& node) -> std::optional<Tape> {
+            Tape tape;
+            Builder builder{tape};
+            if (!builder.visit(node)) {
+                return {};
+            }
+            return tape;
+        }
+
+        inline auto Tape::root() const -> Value {
+            return Value{view(), 0};
+        }
+
+        inline auto View::validate(size_t max_depth) const -> bool {
+            struct Open {
+                size_t start;
+                uint64_t count;
+                bool is_object;
+            };
+            std::vector<Open> open;
+            bool after_key = false;  // 上一个词条是对象的键, 接下来必须是值
+            for (size_t i = 0; i < words.size();) {
+                const auto word = words[i];
+                const auto tag = tag_of(word);
+                const auto payload = payload_of(word);
+                if (open.empty() && i != 0) {
+                    return false;  // 根之后还有内容
+                }
+                const bool in_object = !open.empty() && open.back().is_object;
+                const bool is_key = in_object && !after_key;
+                if (is_key ? tag != '"' && tag != '}' : tag == '}' || (tag == ']' && in_object)) {
+                    return false;
+                }
+                if (!open.empty() && (in_object ? is_key && tag == '"' : tag != ']')) {
+                    ++open.back().count;
+                }
+                switch (tag) {
+                    case 'n': case 't': case 'f': ++i; break;
+                    case 'l': case 'd':
+                        if (i + 2 > words.size()) return false;
+                        i += 2;
+                        break;
+                    case '"': {
+                        if (payload > strings.size() || strings.size() - payload < sizeof(uint32_t)) return false;
+                        uint32_t length = 0;
+                        std::copy_n(strings.data() + payload, sizeof length, reinterpret_cast<char*>(&length));
+                        if (strings.size() - payload - sizeof length < length) return false;
+                        ++i;
+                        break;
+                    }
+                    case '[': case '{': {
+                        const auto end = payload & 0xffffffffu;
+                        if (end <= i + 1 || end > words.size() || open.size() >= max_depth) return false;
+                        open.push_back({i, 0, tag == '{'});
+                        ++i;
+                        break;
+                    }
+                    case ']': case '}': {
+                        if (open.empty() || open.back().is_object != (tag == '}') || payload != open.back().start) {
+                            return false;
+                        }
+                        const auto header = words[open.back().start];
+                        if ((payload_of(header) & 0xffffffffu) != i + 1 ||
+                            payload_of(header) >> 32 != std::min(open.back().count, count_limit)) {
+                            return false;
+                        }
+                        open.pop_back();
+                        ++i;
+                        break;
+                    }
+                    default: return false;
+                }
+                after_key = is_key && tag == '"';
+            }
+            return !words.empty() && open.empty();
+        }
+
+        inline auto Tape::to_binary() const -> std::string {
+            const uint64_t word_count = words.size();
+            const uint64_t string_size = strings.size();
+            std::string bytes;
+            bytes.reserve(header_size + word_count * sizeof(uint64_t) + string_size);
+            const auto append = [&bytes](const auto& value) {
+                bytes.append(reinterpret_cast<const char*>(&value), sizeof value);
+            };
+            bytes.append(magic);
+            append(version);
+            append(byte_order);
+            append(word_count);
+            append(string_size);
+            bytes.append(reinterpret_cast<const char*>(words.data()), word_count * sizeof(uint64_t));
+            bytes.append(strings.data(), string_size);
+            return bytes;
+        }
+
+        inline auto Tape::save(const std::filesystem::path& path) const -> bool {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                return false;
+            }
+            const auto bytes = to_binary();
+            out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            return static_cast<bool>(out.flush());
+        }
+
+        // 检查二进制镜像的文件头与长度, 取出磁带词条个数与字符串缓冲区大小
+        inline auto parse_header(std::string_view bytes, size_t& word_count, size_t& string_size) -> bool {
+            if (bytes.size() < Tape::header_size || bytes.substr(0, Tape::magic.size()) != Tape::magic) {
+                return false;
+            }
+            uint32_t version = 0, byte_order = 0;
+            uint64_t words = 0, strings = 0;
+            std::copy_n(bytes.data() + 8, sizeof version, reinterpret_cast<char*>(&version));
+            std::copy_n(bytes.data() + 12, sizeof byte_order, reinterpret_cast<char*>(&byte_order));
+            std::copy_n(bytes.data() + 16, sizeof words, reinterpret_cast<char*>(&words));
+            std::copy_n(bytes.data() + 24, sizeof strings, reinterpret_cast<char*>(&strings));
+            const auto body = bytes.size() - Tape::header_size;
+            if (version != Tape::version || byte_order != Tape::byte_order || words > body / sizeof(uint64_t) ||
+                strings != body - words * sizeof(uint64_t)) {
+                return false;
+            }
+            word_count = static_cast<size_t>(words);
+            string_size = static_cast<size_t>(strings);
+            return true;
+        }
+
+        inline auto Tape::from_binary(std::string_view bytes, size_t max_depth) -> std::optional<Tape> {
+            size_t word_count = 0, string_size = 0;
+            if (!parse_header(bytes, word_count, string_size)) {
+                return {};
+            }
+            Tape tape;
+            tape.words.resize(word_count);
+            const auto body = bytes.data() + header_size;
+            std::copy_n(body, word_count * sizeof(uint64_t), reinterpret_cast<char*>(tape.words.data()));
+            tape.strings.assign(body + word_count * sizeof(uint64_t), body + word_count * sizeof(uint64_t) + string_size);
+            if (!tape.view().validate(max_depth)) {
+                return {};
+            }
+            return tape;
+        }
+
+        // 映射进内存的二进制镜像, 打开时只检查结构, 之后原地遍历, 不需要解码或分配
+        class Image {
+        protected:
+            JsonIO::MappedFile file;
+            std::optional<Tape> copy;  // 内存未对齐(如非 mmap 读入的小文件)时退回到复制
+            View tape;
+
+            explicit Image(JsonIO::MappedFile file) : file(std::move(file)) {}
+        public:
+            Image(const Image&) = delete;
+            auto operator=(const Image&) -> Image& = delete;
+            // mmap 的地址与 read() 读入的堆内存在移动后都不变, 视图仍然有效
+            Image(Image&&) noexcept = default;
+            auto operator=(Image&&) noexcept -> Image& = default;
+
+            static auto open(const std::filesystem::path& path, size_t max_depth = JsonParser::default_max_depth)
+                -> std::optional<Image> {
+                auto file = JsonIO::MappedFile::open(path);
+                if (!file) {
+                    return {};
+                }
+                const auto bytes = file->view();
+                size_t word_count = 0, string_size = 0;
+                if (!parse_header(bytes, word_count, string_size)) {
+                    return {};
+                }
+                Image image{std::move(*file)};
+                const auto body = image.file.view().data() + Tape::header_size;
+                if (reinterpret_cast<uintptr_t>(body) % alignof(uint64_t) != 0) {
+                    image.copy = Tape::from_binary(image.file.view(), max_depth);
+                    if (!image.copy) {
+                        return {};
+                    }
+                    image.tape = image.copy->view();
+                    return image;
+                }
+                image.tape = View{{reinterpret_cast<const uint64_t*>(body), word_count},
+                                  {body + word_count * sizeof(uint64_t), string_size}};
+                if (!image.tape.validate(max_depth)) {
+                    return {};
+                }
+                return image;
+            }
+
+            [[nodiscard]] auto root() const -> Value { return Value{tape, 0}; }
+            [[nodiscard]] auto view() const -> View { return tape; }
+            [[nodiscard]] auto is_mapped() const -> bool { return file.is_mapped() && !copy; }
+        };
+    }
+
+    namespace JsonPath {
+        using JsonNode::Node;
+        using JsonNode::ArrayNode, JsonNode::ObjectNode;
+        using JsonNode::MonoNode, JsonNode::BoolNode, JsonNode::IntNode, JsonNode::FloatNode, JsonNode::StringNode;
+
+        // 编译后的路径: RFC 6901 JSON Pointer, 另外支持两种扩展片段
+        //   `*`               匹配对象的所有成员或数组的所有元素
+        //   `*[key=literal]`  同上, 但只保留成员 key 等于 json 字面量的对象; `!=` 取反
+        //                     literal 必须恰好是一个标量, 按 validate 严格检查; key 在第一个 `=` 处结束,
+        //                     所以含 `=` 或以 `!` 结尾的成员名不能作为过滤条件
+        // 例如 "/user/id", "/events/*/ts", "/events/*[type=\"click\"]/ts"
+        // 编译一次后可以反复求值; 在 Node 上求值不复制节点, 在按需解析的输入上求值时不匹配的子树只被跳过
+        // 紧凑数组(Int64Array/DoubleArray)的元素不是 Node, 下标与通配符都不进入其中: 路径可以停在紧凑数组上,
+        // 元素用 as_span 读取; 需要按元素匹配时先 unpack, 或解析时不开启 set_pack_threshold
+        class Path {
+        protected:
+            struct Step {
+                bool wildcard = false;
+                std::string key;                  // 成员名, 同时也是数组下标的原文
+                std::optional<size_t> index;      // key 是合法的数组下标时
+                std::string filter_key;           // 为空表示没有过滤条件
+                Node filter_value;
+                bool filter_negate = false;
+            };
+            std::vector<Step> steps;
+
+            // ~1 表示 `/`, ~0 表示 `~`, 其他转义不合法
+            static auto unescape(std::string_view token, std::string& out) -> bool {
+                out.clear();
+                for (size_t i = 0; i < token.size(); ++i) {
+                    if (token[i] != '~') {
+                        out.push_back(token[i]);
+                        continue;
+                    }
+                    if (++i == token.size() || (token[i] != '0' && token[i] != '1')) {
+                        return false;
+                    }
+                    out.push_back(token[i] == '0' ? '~' : '/');
+                }
+                return true;
+            }
+            // 数组下标不能有前导零; `-` 指向末尾之后, 永远不匹配
+            static auto parse_index(std::string_view token) -> std::optional<size_t> {
+                if (token.empty() || (token.size() > 1 && token[0] == '0')) {
+                    return {};
+                }
+                size_t index = 0;
+                const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), index);
+                if (error != std::errc{} || end != token.data() + token.size()) {
+                    return {};
+                }
+                return index;
+            }
+            static auto parse_filter(std::string_view filter, Step& step) -> bool {
+                const auto equal = filter.find('=');
+                if (equal == std::string_view::npos || equal == 0) {
+                    return false;
+                }
+                step.filter_negate = filter[equal - 1] == '!';
+                step.filter_key = filter.substr(0, step.filter_negate ? equal - 1 : equal);
+                // Node::from_str 是宽松的, 会忽略字面量之后的内容, 所以先严格检查
+                const auto literal = filter.substr(equal + 1);
+                if (!JsonValidate::validate(literal)) {
+                    return false;
+                }
+                auto value = Node::from_str(literal);
+                if (step.filter_key.empty() || !value || value->is<ArrayNode>() || value->is<ObjectNode>()) {
+                    return false;
+                }
+                step.filter_value = std::move(*value);
+                return true;
+            }
+
+            // 标量比较, 整数与浮点数按数值比较
+            static auto equals(const Node& lhs, const Node& rhs) -> bool {
+                const auto number = [](const Node& node) -> std::optional<FloatNode> {
+                    if (auto integer = node.get_if<IntNode>()) return static_cast<FloatNode>(*integer);
+                    if (auto floating = node.get_if<FloatNode>()) return *floating;
+                    return {};
+                };
+                if (lhs.is<IntNode>() && rhs.is<IntNode>()) {
+                    return *lhs.get_if<IntNode>() == *rhs.get_if<IntNode>();
+                }
+                if (const auto a = number(lhs), b = number(rhs); a && b) {
+                    return *a == *b;
+                }
+                if (lhs.Value().index() != rhs.Value().index()) {
+                    return false;
+                }
+                if (auto str = lhs.get_if<StringNode>()) {
+                    return *str == *rhs.get_if<StringNode>();
+                }
+                if (auto boolean = lhs.get_if<BoolNode>()) {
+                    return *boolean == *rhs.get_if<BoolNode>();
+                }
+                return lhs.is<MonoNode>();
+            }
+            static auto equals(const JsonOnDemand::Value& lhs, const Node& rhs, std::string& scratch) -> bool {
+                using JsonOnDemand::Type;
+                switch (lhs.type()) {
+                    case Type::Null: return rhs.is<MonoNode>();
+                    case Type::Bool: return rhs.is<BoolNode>() && lhs.as<BoolNode>() == *rhs.get_if<BoolNode>();
+                    case Type::String: {
+                        const auto str = lhs.get_string(scratch);
+                        return str && rhs.is<StringNode>() && *str == std::string_view{*rhs.get_if<StringNode>()};
+                    }
+                    case Type::Number: {
+                        if (const auto integer = lhs.as<IntNode>(); integer && rhs.is<IntNode>()) {
+                            return *integer == *rhs.get_if<IntNode>();
+                        }
+                        const auto floating = lhs.as<FloatNode>();
+                        if (auto value = rhs.get_if<FloatNode>()) return floating == *value;
+                        if (auto value = rhs.get_if<IntNode>()) return floating == static_cast<FloatNode>(*value);
+                        return false;
+                    }
+                    default: return false;
+                }
+            }
+
+            [[nodiscard]] static auto passes(const Step& step, const Node& node) -> bool {
+                if (step.filter_key.empty()) {
+                    return true;
+                }
+                const auto member = node.is<ObjectNode>() ? node.find(step.filter_key) : nullptr;
+                return (member != nullptr && equals(*member, step.filter_value)) != step.filter_negate;
+            }
+            [[nodiscard]] static auto passes(const Step& step, const JsonOnDemand::Value& value, std::string& scratch) -> bool {
+                if (step.filter_key.empty()) {
+                    return true;
+                }
+                const auto member = value.find(step.filter_key);
+                return (member && equals(*member, step.filter_value, scratch)) != step.filter_negate;
+            }
+
+            // 从第 depth 步开始匹配, visitor 返回 false 时停止; 返回是否继续
+            template<typename NodeT, typename Visitor>
+            auto visit(NodeT& node, size_t depth, Visitor& visitor) const -> bool {
+                if (depth == steps.size()) {
+                    return visitor(node);
+                }
+                const auto& step = steps[depth];
+                if (step.wildcard) {
+                    if (auto array = node.template get_if<ArrayNode>()) {
+                        for (auto& element : *array) {
+                            if (passes(step, element) && !visit(element, depth + 1, visitor)) return false;
+                        }
+                    } else if (auto object = node.template get_if<ObjectNode>()) {
+                        for (auto& member : *object) {
+                            if (passes(step, member.second) && !visit(member.second, depth + 1, visitor)) return false;
+                        }
+                    }
+                    return true;
+                }
+                if (auto object = node.template get_if<ObjectNode>()) {
+                    if (auto it = object->find(step.key); it != object->end()) {
+                        return visit(it->second, depth + 1, visitor);
+                    }
+                } else if (auto array = node.template get_if<ArrayNode>(); array && step.index && *step.index < array->size()) {
+                    return visit((*array)[*step.index], depth + 1, visitor);
+                }
+                return true;
+            }
+
+            template<typename Visitor>
+            auto visit(const JsonOnDemand::Value& value, size_t depth, Visitor& visitor, std::string& scratch) const -> bool {
+                using JsonOnDemand::Type;
+                if (depth == steps.size()) {
+                    return visitor(value);
+                }
+                const auto& step = steps[depth];
+                const auto type = value.type();
+                if (step.wildcard) {
+                    if (type == Type::Array) {
+                        for (const auto& element : value.elements()) {
+                            if (passes(step, element, scratch) && !visit(element, depth + 1, visitor, scratch)) return false;
+                        }
+                    } else if (type == Type::Object) {
+                        for (auto it = value.fields().begin(); it != JsonOnDemand::ObjectIterator{}; ++it) {
+                            if (passes(step, it.value(), scratch) && !visit(it.value(), depth + 1, visitor, scratch)) return false;
+                        }
+                    }
+                    return true;
+                }
+                std::optional<JsonOnDemand::Value> child;
+                if (type == Type::Object) {
+                    child = value.find(step.key);
+                } else if (type == Type::Array && step.index) {
+                    child = value.at(*step.index);
+                }
+                return !child || visit(*child, depth + 1, visitor, scratch);
+            }
+        public:
+            Path() = default;
+
+            // 空字符串表示整个文档; 语法错误时返回空
+            static auto compile(std::string_view pointer) -> std::optional<Path> {
+                Path path;
+                if (pointer.empty()) {
+                    return path;
+                }
+                if (pointer.front() != '/') {
+                    return {};
+                }
+                pointer.remove_prefix(1);
+                while (true) {
+                    const auto slash = pointer.find('/');
+                    const auto token = pointer.substr(0, slash);
+                    Step step;
+                    if (!unescape(token, step.key)) {
+                        return {};
+                    }
+                    if (token == "*") {
+                        step.wildcard = true;
+                    } else if (token.size() > 3 && token.substr(0, 2) == "*[" && token.back() == ']') {
+                        step.wildcard = true;
+                        if (!parse_filter(std::string_view{step.key}.substr(2, step.key.size() - 3), step)) {
+                            return {};
+                        }
+                    } else {
+                        step.index = parse_index(step.key);
+                    }
+                    path.steps.push_back(std::move(step));
+                    if (slash == std::string_view::npos) {
+                        return path;
+                    }
+                    pointer.remove_prefix(slash + 1);
+                }
+            }
+
+            [[nodiscard]] auto size() const -> size_t { return steps.size(); }
+            // 第 depth 步的成员名(已去掉 ~0 ~1 转义)与作为数组下标时的值
+            [[nodiscard]] auto key(size_t depth) const -> const std::string& { return steps[depth].key; }
+            [[nodiscard]] auto index(size_t depth) const -> std::optional<size_t> { return steps[depth].index; }
+            // 不含通配符时最多只有一个匹配
+            [[nodiscard]] auto is_pointer() const -> bool {
+                return std::none_of(steps.begin(), steps.end(), [](const Step& step) { return step.wildcard; });
+            }
+
+            // 按文档顺序访问所有匹配, visitor(Node&) 返回 bool, 返回 false 时停止
+            template<typename Visitor>
+            void for_each(Node& root, Visitor&& visitor) const {
+                visit(root, 0, visitor);
+            }
+            template<typename Visitor>
+            void for_each(const Node& root, Visitor&& visitor) const {
+                visit(root, 0, visitor);
+            }
+            // 在输入上直接匹配, visitor(const JsonOnDemand::Value&)
+            template<typename Visitor>
+            void for_each(const JsonOnDemand::Value& root, Visitor&& visitor) const {
+                std::string scratch;
+                visit(root, 0, visitor, scratch);
+            }
+
+            // 第一个匹配, 没有时返回 nullptr
+            auto find(Node& root) const -> Node* {
+                Node* result = nullptr;
+                for_each(root, [&](Node& node) {
+                    result = &node;
+                    return false;
+                });
+                return result;
+            }
+            [[nodiscard]] auto find(const Node& root) const -> const Node* {
+                return find(const_cast<Node&>(root));
+            }
+            [[nodiscard]] auto find(const JsonOnDemand::Value& root) const -> std::optional<JsonOnDemand::Value> {
+                std::optional<JsonOnDemand::Value> result;
+                for_each(root, [&](const JsonOnDemand::Value& value) {
+                    result = value;
+                    return false;
+                });
+                return result;
+            }
+
+            [[nodiscard]] auto select(const Node& root) const -> std::vector<const Node*> {
+                std::vector<const Node*> result;
+                for_each(root, [&](const Node& node) {
+                    result.push_back(&node);
+                    return true;
+                });
+                return result;
+            }
+            [[nodiscard]] auto select(const JsonOnDemand::Value& root) const -> std::vector<JsonOnDemand::Value> {
+                std::vector<JsonOnDemand::Value> result;
+                for_each(root, [&](const JsonOnDemand::Value& value) {
+                    result.push_back(value);
+                    return true;
+                });
+                return result;
+            }
+        };
+    }
+
+    namespace JsonPatch {
+        using JsonNode::Node;
+        using JsonNode::ArrayNode, JsonNode::ObjectNode, JsonNode::Int64Array, JsonNode::DoubleArray;
+        using JsonNode::MonoNode, JsonNode::ValueType, JsonNode::BoolNode, JsonNode::IntNode, JsonNode::FloatNode, JsonNode::StringNode;
+
+        // 哈希、比较、差分与合并都沿树的深度递归, 与 Node 自身的复制和析构相同:
+        // 只用于不超过解析器深度限制(JsonParser::default_max_depth)的树, 更深的树可能耗尽线程栈
+
+        // 结构哈希: 对象与成员顺序无关, 紧凑数组与同样内容的 ArrayNode 相同
+        // 相同的树哈希一定相同; 哈希不同的子树一定不同, 可以不比较直接进入
+        namespace detail {
+            constexpr auto mix(uint64_t value) -> uint64_t {
+                value ^= value >> 30;
+                value *= 0xbf58476d1ce4e5b9ULL;
+                value ^= value >> 27;
+                value *= 0x94d049bb133111ebULL;
+                return value ^ (value >> 31);
+            }
+            inline auto hash_string(std::string_view str) -> uint64_t {
+                return mix(std::hash<std::string_view>{}(str));
+            }
+            inline auto hash_int(IntNode value) -> uint64_t {
+                return mix(static_cast<uint64_t>(value) ^ 0x243f6a8885a308d3ULL);
+            }
+            inline auto hash_float(FloatNode value) -> uint64_t {
+                return mix(std::bit_cast<uint64_t>(value == 0 ? 0.0 : value) ^ 0x13198a2e03707344ULL);
+            }
+
+            // 数组元素的统一视图, 普通数组与紧凑数组共用一套比较和差分
+            inline auto array_size(const Node& node) -> size_t {
+                if (auto array = node.get_if<ArrayNode>()) return array->size();
+                if (auto ints = node.get_if<Int64Array>()) return ints->size();
+                if (auto doubles = node.get_if<DoubleArray>()) return doubles->size();
+                return 0;
+            }
+            inline auto is_array(const Node& node) -> bool {
+                return node.is<ArrayNode>() || node.is_packed();
+            }
+            // 第 index 个元素; 紧凑数组的元素临时构造到 scratch 中
+            inline auto element(const Node& node, size_t index, Node& scratch) -> const Node& {
+                if (auto array = node.get_if<ArrayNode>()) return (*array)[index];
+                if (auto ints = node.get_if<Int64Array>()) {
+                    scratch.Value().emplace<IntNode>((*ints)[index]);
+                } else {
+                    scratch.Value().emplace<FloatNode>((*node.get_if<DoubleArray>())[index]);
+                }
+                return scratch;
+            }
+        }
+
+        inline auto hash(const Node& node) -> uint64_t {
+            using namespace detail;
+            return std::visit(
+                []<typename T0>(const T0& arg) -> uint64_t {
+                    using T = std::decay_t<T0>;
+                    if constexpr (std::is_same_v<T, MonoNode>) {
+                        return mix(1);
+                    } else if constexpr (std::is_same_v<T, BoolNode>) {
+                        return mix(arg ? 3 : 2);
+                    } else if constexpr (std::is_same_v<T, IntNode>) {
+                        return hash_int(arg);
+                    } else if constexpr (std::is_same_v<T, FloatNode>) {
+                        return hash_float(arg);
+                    } else if constexpr (std::is_same_v<T, StringNode>) {
+                        return hash_string(arg);
+                    } else if constexpr (std::is_same_v<T, ObjectNode>) {
+                        // 成员哈希相加, 与顺序无关
+                        uint64_t sum = mix(arg.size() + 0x5bd1e995);
+                        for (const auto& [key, value] : arg) {
+                            sum += mix(hash_string(key) * 31 + hash(value));
+                        }
+                        return sum;
+                    } else {
+                        uint64_t state = mix(arg.size() + 0x9e3779b9);
+                        for (const auto& element : arg) {
+                            if constexpr (std::is_same_v<T, ArrayNode>) {
+                                state = mix(state * 31 + hash(element));
+                            } else if constexpr (std::is_same_v<T, Int64Array>) {
+                                state = mix(state * 31 + hash_int(element));
+                            } else {
+                                state = mix(state * 31 + hash_float(element));
+                            }
+                        }
+                        return state;
+                    }
+                },
+                node.Value());
+        }
+
+        // 深度比较, 对象与成员顺序无关; numeric 为 true 时整数与浮点数按数值比较(RFC 6902 的 test)
+        inline auto equal(const Node& lhs, const Node& rhs, bool numeric = false) -> bool {
+            if (numeric) {
+                const auto number = [](const Node& node) -> std::optional<FloatNode> {
+                    if (auto integer = node.get_if<IntNode>()) return static_cast<FloatNode>(*integer);
+                    if (auto floating = node.get_if<FloatNode>()) return *floating;
+                    return {};
+                };
+                if (!(lhs.is<IntNode>() && rhs.is<IntNode>())) {
+                    if (const auto a = number(lhs), b = number(rhs); a && b) return *a == *b;
+                }
+            }
+            if (detail::is_array(lhs) && detail::is_array(rhs)) {
+                const auto size = detail::array_size(lhs);
+                if (size != detail::array_size(rhs)) return false;
+                Node left, right;
+                for (size_t i = 0; i < size; ++i) {
+                    if (!equal(detail::element(lhs, i, left), detail::element(rhs, i, right), numeric)) return false;
+                }
+                return true;
+            }
+            if (lhs.Value().index() != rhs.Value().index()) {
+                return false;
+            }
+            if (auto object = lhs.get_if<ObjectNode>()) {
+                const auto& other = *rhs.get_if<ObjectNode>();
+                if (object->size() != other.size()) return false;
+                for (const auto& [key, value] : *object) {
+                    const auto it = other.find(key.view());
+                    if (it == other.end() || !equal(value, it->second, numeric)) return false;
+                }
+                return true;
+            }
+            if (auto str = lhs.get_if<StringNode>()) return *str == *rhs.get_if<StringNode>();
+            if (auto boolean = lhs.get_if<BoolNode>()) return *boolean == *rhs.get_if<BoolNode>();
+            if (auto integer = lhs.get_if<IntNode>()) return *integer == *rhs.get_if<IntNode>();
+            if (auto floating = lhs.get_if<FloatNode>()) return *floating == *rhs.get_if<FloatNode>();
+            return true;  // null
+        }
+
+        // JSON Pointer 的一个片段: `~` 写作 ~0, `/` 写作 ~1
+        inline void append_token(std::string& pointer, std::string_view token) {
+            pointer.push_back('/');
+            for (const auto ch : token) {
+                if (ch == '~') {
+                    pointer.append("~0");
+                } else if (ch == '/') {
+                    pointer.append("~1");
+                } else {
+                    pointer.push_back(ch);
+                }
+            }
+        }
+
+        // 把 JSON Pointer 拆成片段; 与 JsonPath::Path 不同, `*` 只是普通的键
+        inline auto split_pointer(std::string_view pointer) -> std::optional<std::vector<std::string>> {
+            std::vector<std::string> tokens;
+            if (pointer.empty()) {
+                return tokens;
+            }
+            if (pointer.front() != '/') {
+                return {};
+            }
+            pointer.remove_prefix(1);
+            while (true) {
+                const auto slash = pointer.find('/');
+                const auto raw = pointer.substr(0, slash);
+                auto& token = tokens.emplace_back();
+                for (size_t i = 0; i < raw.size(); ++i) {
+                    if (raw[i] != '~') {
+                        token.push_back(raw[i]);
+                    } else if (i + 1 < raw.size() && (raw[i + 1] == '0' || raw[i + 1] == '1')) {
+                        token.push_back(raw[++i] == '0' ? '~' : '/');
+                    } else {
+                        return {};
+                    }
+                }
+                if (slash == std::string_view::npos) {
+                    return tokens;
+                }
+                pointer.remove_prefix(slash + 1);
+            }
+        }
+
+        // 生成 RFC 6902 JSON Patch: 一个由 {"op", "path", "value"} 组成的数组, 对 source 依次执行后等于 target
+        // 先对两棵树各算一遍子树哈希, 哈希相同的分支只比较一次, 不再深入; 数组先去掉相同的首尾再逐个比较
+        class Differ {
+        protected:
+            std::unordered_map<const Node*, uint64_t> hashes;
+            Node patch{ValueType{std::in_place_type<ArrayNode>}};
+            std::string path;
+
+            // 后序遍历记下每个子树的哈希, 返回 node 的哈希
+            auto index(const Node& node) -> uint64_t {
+                uint64_t value = 0;
+                if (auto object = node.get_if<ObjectNode>()) {
+                    value = detail::mix(object->size() + 0x5bd1e995);
+                    for (const auto& [key, element] : *object) {
+                        value += detail::mix(detail::hash_string(key) * 31 + index(element));
+                    }
+                } else if (auto array = node.get_if<ArrayNode>()) {
+                    value = detail::mix(array->size() + 0x9e3779b9);
+                    for (const auto& element : *array) {
+                        value = detail::mix(value * 31 + index(element));
+                    }
+                } else {
+                    value = hash(node);
+                }
+                hashes.emplace(&node, value);
+                return value;
+            }
+            [[nodiscard]] auto hash_of(const Node& node) const -> uint64_t {
+                const auto it = hashes.find(&node);
+                return it != hashes.end() ? it->second : hash(node);
+            }
+            [[nodiscard]] auto same(const Node& lhs, const Node& rhs) const -> bool {
+                return hash_of(lhs) == hash_of(rhs) && equal(lhs, rhs);
+            }
+
+            void emit(std::string_view op, const Node* value) {
+                Node operation{ValueType{std::in_place_type<ObjectNode>}};
+                auto& object = *operation.get_if<ObjectNode>();
+                object.insert_or_assign("op", Node{ValueType{std::in_place_type<StringNode>, op}});
+                object.insert_or_assign("path", Node{ValueType{std::in_place_type<StringNode>, path}});
+                if (value) {
+                    object.insert_or_assign("value", Node{*value});
+                }
+                patch.get_if<ArrayNode>()->push_back(std::move(operation));
+            }
+
+            void diff_objects(const ObjectNode& source, const ObjectNode& target) {
+                const auto length = path.size();
+                for (const auto& [key, value] : source) {
+                    if (!target.contains(key.view())) {
+                        append_token(path, key);
+                        emit("remove", nullptr);
+                        path.resize(length);
+                    }
+                }
+                for (const auto& [key, value] : target) {
+                    append_token(path, key);
+                    if (const auto it = source.find(key.view()); it == source.end()) {
+                        emit("add", &value);
+                    } else {
+                        diff(it->second, value);
+                    }
+                    path.resize(length);
+                }
+            }
+
+            void diff_arrays(const Node& source, const Node& target) {
+                const auto length = path.size();
+                const auto source_size = detail::array_size(source);
+                const auto target_size = detail::array_size(target);
+                Node left, right;
+                const auto same_at = [&](size_t i, size_t j) {
+                    return same(detail::element(source, i, left), detail::element(target, j, right));
+                };
+                size_t prefix = 0;
+                while (prefix < source_size && prefix < target_size && same_at(prefix, prefix)) ++prefix;
+                size_t suffix = 0;
+                while (suffix < source_size - prefix && suffix < target_size - prefix &&
+                       same_at(source_size - 1 - suffix, target_size - 1 - suffix)) {
+                    ++suffix;
+                }
+                const auto source_middle = source_size - prefix - suffix;
+                const auto target_middle = target_size - prefix - suffix;
+                const auto common = std::min(source_middle, target_middle);
+                for (size_t i = 0; i < common; ++i) {
+                    path.resize(length);
+                    append_token(path, std::to_string(prefix + i));
+                    diff(detail::element(source, prefix + i, left), detail::element(target, prefix + i, right));
+                }
+                // 多出的元素从后往前删除, 下标不受先前操作的影响
+                for (auto i = source_middle; i > common; --i) {
+                    path.resize(length);
+                    append_token(path, std::to_string(prefix + i - 1));
+                    emit("remove", nullptr);
+                }
+                for (auto i = common; i < target_middle; ++i) {
+                    path.resize(length);
+                    append_token(path, std::to_string(prefix + i));
+                    emit("add", &detail::element(target, prefix + i, right));
+                }
+                path.resize(length);
+            }
+
+            void diff(const Node& source, const Node& target) {
+                if (same(source, target)) {
+                    return;
+                }
+                if (auto object = source.get_if<ObjectNode>(); object && target.is<ObjectNode>()) {
+                    diff_objects(*object, *target.get_if<ObjectNode>());
+                } else if (detail::is_array(source) && detail::is_array(target)) {
+                    diff_arrays(source, target);
+                } else {
+                    emit("replace", &target);
+                }
+            }
+        public:
+            auto run(const Node& source, const Node& target) -> Node {
+                hashes.clear();
+                index(source);
+                index(target);
+                path.clear();
+                patch.get_if<ArrayNode>()->clear();
+                diff(source, target);
+                return std::move(patch);
+            }
+        };
+
+        inline auto diff(const Node& source, const Node& target) -> Node {
+            return Differ{}.run(source, target);
+        }
+
+        // 就地执行 RFC 6902 JSON Patch, 出错时返回 false
+        // 每个操作在撤销日志中记下被覆盖或删除的值, rollback 按相反顺序恢复, 整个 patch 要么全部生效要么不生效
+        // 日志只保存被修改的节点而不是整棵树; patch 为右值时 value 被移动而不是复制
+        class Applier {
+        protected:
+            struct Undo {
+                enum class Kind { Assign, Erase, Insert } kind;
+                std::vector<std::string> tokens;  // 数组下标已经确定, 不含 `-`
+                // Assign/Insert 恢复的值; Insert 为空时使用前一步 Erase 取回的值(move 操作)
+                std::optional<Node> value;
+                size_t position = 0;       // Insert 到对象时成员原来的位置
+                JsonNode::Key key;         // 被删除的键是驻留的时沿用原来的句柄
+
+                Undo(Kind kind, std::vector<std::string> tokens, std::optional<Node> value = {})
+                    : kind(kind), tokens(std::move(tokens)), value(std::move(value)) {}
+            };
+
+            Node& root;
+            std::vector<Undo> undo;
+
+            // 沿 tokens[0, count) 找到节点, 途经的紧凑数组被就地展开以便按 Node 修改
+            auto walk(const std::vector<std::string>& tokens, size_t count) -> Node* {
+                Node* node = &root;
+                for (size_t i = 0; i < count; ++i) {
+                    node->unpack();
+                    if (auto object = node->get_if<ObjectNode>()) {
+                        const auto it = object->find(tokens[i]);
+                        if (it == object->end()) return nullptr;
+                        node = &it->second;
+                    } else if (auto array = node->get_if<ArrayNode>()) {
+                        const auto index = array_index(tokens[i], array->size());
+                        if (!index || *index >= array->size()) return nullptr;
+                        node = &(*array)[*index];
+                    } else {
+                        return nullptr;
+                    }
+                }
+                node->unpack();
+                return node;
+            }
+            // 不允许前导零; `-` 表示末尾之后
+            static auto array_index(std::string_view token, size_t size) -> std::optional<size_t> {
+                if (token == "-") return size;
+                if (token.empty() || (token.size() > 1 && token[0] == '0')) return {};
+                size_t index = 0;
+                const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), index);
+                if (error != std::errc{} || end != token.data() + token.size()) return {};
+                return index;
+            }
+
+            // 用确定的数组下标替换最后一个片段
+            static auto resolved(const std::vector<std::string>& tokens, size_t index) -> std::vector<std::string> {
+                auto result = tokens;
+                result.back() = std::to_string(index);
+                return result;
+            }
+
+            // 覆盖已有的节点, 旧值进入撤销日志
+            void assign(Node& target, const std::vector<std::string>& tokens, Node&& value) {
+                undo.push_back({Undo::Kind::Assign, tokens, std::move(target)});
+                target = std::move(value);
+            }
+
+            auto add(const std::vector<std::string>& tokens, Node&& value) -> bool {
+                if (tokens.empty()) {
+                    assign(root, tokens, std::move(value));
+                    return true;
+                }
+                auto parent = walk(tokens, tokens.size() - 1);
+                if (parent == nullptr) return false;
+                if (auto object = parent->get_if<ObjectNode>()) {
+                    if (const auto it = object->find(tokens.back()); it != object->end()) {
+                        assign(it->second, tokens, std::move(value));
+                    } else {
+                        object->try_emplace(tokens.back(), std::move(value));
+                        undo.push_back({Undo::Kind::Erase, tokens});
+                    }
+                    return true;
+                }
+                if (auto array = parent->get_if<ArrayNode>()) {
+                    const auto index = array_index(tokens.back(), array->size());
+                    if (!index || *index > array->size()) return false;
+                    array->insert(array->begin() + static_cast<std::ptrdiff_t>(*index), std::move(value));
+                    undo.push_back({Undo::Kind::Erase, resolved(tokens, *index)});
+                    return true;
+                }
+                return false;
+            }
+            // 取出并删除; 失败时返回空
+            // 撤销日志只记下位置, 调用者负责把取出的值放进日志(remove), 或者再把它加回树中(move)
+            auto take(const std::vector<std::string>& tokens) -> std::optional<Node> {
+                if (tokens.empty()) {
+                    return {};
+                }
+                auto parent = walk(tokens, tokens.size() - 1);
+                if (parent == nullptr) return {};
+                if (auto object = parent->get_if<ObjectNode>()) {
+                    const auto it = object->find(tokens.back());
+                    if (it == object->end()) return {};
+                    Undo entry{Undo::Kind::Insert, tokens};
+                    entry.position = static_cast<size_t>(it - object->begin());
+                    if (it->first.is_interned()) {
+                        entry.key = it->first;
+                    }
+                    Node value = std::move(it->second);
+                    object->erase(tokens.back());
+                    undo.push_back(std::move(entry));
+                    return value;
+                }
+                if (auto array = parent->get_if<ArrayNode>()) {
+                    const auto index = array_index(tokens.back(), array->size());
+                    if (!index || *index >= array->size()) return {};
+                    Node value = std::move((*array)[*index]);
+                    array->erase(array->begin() + static_cast<std::ptrdiff_t>(*index));
+                    undo.push_back({Undo::Kind::Insert, resolved(tokens, *index)});
+                    return value;
+                }
+                return {};
+            }
+        public:
+            explicit Applier(Node& root) : root(root) {}
+
+            // 按相反顺序撤销之前成功执行的所有操作, 树恢复到构造时的内容(途经的紧凑数组保持展开)
+            void rollback() {
+                auto entries = std::move(undo);
+                undo.clear();
+                Node carried;  // Erase 取回、供紧接着的 Insert 使用的值
+                for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+                    auto& tokens = it->tokens;
+                    switch (it->kind) {
+                        case Undo::Kind::Assign:
+                            *walk(tokens, tokens.size()) = std::move(*it->value);
+                            break;
+                        case Undo::Kind::Erase:
+                            carried = std::move(*take(tokens));
+                            break;
+                        case Undo::Kind::Insert: {
+                            auto value = it->value ? std::move(*it->value) : std::move(carried);
+                            auto parent = walk(tokens, tokens.size() - 1);
+                            if (auto object = parent->get_if<ObjectNode>()) {
+                                if (it->key.is_interned()) {
+                                    object->insert_at(it->position, it->key, std::move(value));
+                                } else {
+                                    object->insert_at(it->position, std::string_view{tokens.back()}, std::move(value));
+                                }
+                            } else {
+                                auto& array = *parent->get_if<ArrayNode>();
+                                array.insert(array.begin() + static_cast<std::ptrdiff_t>(*array_index(tokens.back(), array.size())),
+                                             std::move(value));
+                            }
+                            break;
+                        }
+                    }
+                }
+                undo.clear();
+            }
+            // 接受目前为止的修改, 丢弃撤销日志
+            void commit() {
+                undo.clear();
+            }
+
+            auto apply(Node& operation, bool movable) -> bool {
+                auto object = operation.get_if<ObjectNode>();
+                if (object == nullptr) return false;
+                const auto field = [&](std::string_view name) -> Node* {
+                    const auto it = object->find(name);
+                    return it == object->end() ? nullptr : &it->second;
+                };
+                const auto op = field("op");
+                const auto path_node = field("path");
+                if (!op || !op->is<StringNode>() || !path_node || !path_node->is<StringNode>()) return false;
+                const auto tokens = split_pointer(*path_node->get_if<StringNode>());
+                if (!tokens) return false;
+                const std::string_view name = *op->get_if<StringNode>();
+                const auto value = [&]() -> std::optional<Node> {
+                    auto node = field("value");
+                    if (!node) return {};
+                    return movable ? std::move(*node) : Node{*node};
+                };
+                const auto from = [&]() -> std::optional<std::vector<std::string>> {
+                    auto node = field("from");
+                    if (!node || !node->is<StringNode>()) return {};
+                    return split_pointer(*node->get_if<StringNode>());
+                };
+                if (name == "add") {
+                    auto node = value();
+                    return node && add(*tokens, std::move(*node));
+                }
+                if (name == "remove") {
+                    auto node = take(*tokens);
+                    if (!node) return false;
+                    undo.back().value = std::move(*node);
+                    return true;
+                }
+                if (name == "replace") {
+                    auto target = walk(*tokens, tokens->size());
+                    auto node = value();
+                    if (!target || !node) return false;
+                    assign(*target, *tokens, std::move(*node));
+                    return true;
+                }
+                if (name == "move") {
+                    const auto source = from();
+                    if (!source) return false;
+                    // 不能移动到自己的子节点里
+                    if (source->size() < tokens->size() && std::equal(source->begin(), source->end(), tokens->begin())) return false;
+                    if (*source == *tokens) return walk(*source, source->size()) != nullptr;
+                    auto node = take(*source);
+                    if (!node) return false;
+                    if (!add(*tokens, std::move(*node))) {
+                        // 目标不存在时值已经取出但没有放回, 先把它交给日志, 由 rollback 放回原处
+                        undo.back().value = std::move(*node);
+                        return false;
+                    }
+                    return true;
+                }
+                if (name == "copy") {
+                    const auto source = from();
+                    const auto node = source ? walk(*source, source->size()) : nullptr;
+                    return node && add(*tokens, Node{*node});
+                }
+                if (name == "test") {
+                    const auto target = walk(*tokens, tokens->size());
+                    const auto expected = field("value");
+                    return target && expected && equal(*target, *expected, true);
+                }
+                return false;
+            }
+        };
+
+        inline auto apply(Node& target, const Node& patch) -> bool {
+            auto operations = patch.get_if<ArrayNode>();
+            if (operations == nullptr) return false;
+            Applier applier{target};
+            for (const auto& operation : *operations) {
+                Node copy = operation;  // 只复制一个操作, value 也随之复制
+                if (!applier.apply(copy, true)) {
+                    applier.rollback();
+                    return false;
+                }
+            }
+            applier.commit();
+            return true;
+        }
+        inline auto apply(Node& target, Node&& patch) -> bool {
+            auto operations = patch.get_if<ArrayNode>();
+            if (operations == nullptr) return false;
+            Applier applier{target};
+            for (auto& operation : *operations) {
+                if (!applier.apply(operation, true)) {
+                    applier.rollback();
+                    return false;
+                }
+            }
+            applier.commit();
+            return true;
+        }
+
+        // RFC 7386 JSON Merge Patch: 目标中的 null 表示删除, 所以无法表达"把成员设为 null"
+        inline auto merge_diff(const Node& source, const Node& target) -> Node {
+            const auto source_object = source.get_if<ObjectNode>();
+            const auto target_object = target.get_if<ObjectNode>();
+            if (!source_object || !target_object) {
+                return Node{target};
+            }
+            Node patch{ValueType{std::in_place_type<ObjectNode>}};
+            auto& members = *patch.get_if<ObjectNode>();
+            for (const auto& [key, value] : *source_object) {
+                if (!target_object->contains(key.view())) {
+                    members.insert_or_assign(key.view(), Node{});
+                }
+            }
+            for (const auto& [key, value] : *target_object) {
+                const auto it = source_object->find(key.view());
+                if (it == source_object->end()) {
+                    members.insert_or_assign(key.view(), Node{value});
+                } else if (!(hash(it->second) == hash(value) && equal(it->second, value))) {
+                    members.insert_or_assign(key.view(), merge_diff(it->second, value));
+                }
+            }
+            return patch;
+        }
+
+        // 就地合并; patch 为右值时其中的值被移动
+        template<typename Patch>
+            requires std::same_as<std::remove_cvref_t<Patch>, Node>
+        void merge_apply(Node& target, Patch&& patch) {
+            auto members = patch.template get_if<ObjectNode>();
+            if (members == nullptr) {
+                target = std::forward<Patch>(patch);
+                return;
+            }
+            if (!target.is<ObjectNode>()) {
+                target = Node{ValueType{std::in_place_type<ObjectNode>}};
+            }
+            auto& object = *target.get_if<ObjectNode>();
+            for (auto& [key, value] : *members) {
+                if (value.template is<MonoNode>()) {
+                    object.erase(key.view());
+                } else if (value.template is<ObjectNode>()) {
+                    if constexpr (std::is_rvalue_reference_v<Patch&&>) {
+                        merge_apply(object[key.view()], std::move(value));
+                    } else {
+                        merge_apply(object[key.view()], std::as_const(value));
+                    }
+                } else if constexpr (std::is_rvalue_reference_v<Patch&&>) {
+                    object.insert_or_assign(key.view(), std::move(value));
+                } else {
+                    object.insert_or_assign(key.view(), Node{value});
+                }
+            }
+        }
+    }
+
+    namespace JsonShared {
+        using JsonNode::Node;
+        using JsonNode::ArrayNode, JsonNode::ObjectNode;
+        using JsonNode::MonoNode, JsonNode::BoolNode, JsonNode::IntNode, JsonNode::FloatNode, JsonNode::StringNode;
+        using JsonPath::Path;
+
+        class Value;
+        using Ptr = std::shared_ptr<const Value>;
+
+        // 不可变的引用计数节点, 可以同时被任意多个线程读取
+        // 修改通过 with/without 生成新的根: 路径上的每个容器复制一次成员数组, 其中只是子节点与键的引用计数加一,
+        // 对象的排序索引按一次插入或删除调整而不重新排序; 其余子树与键都与旧根共享
+        // 字符串使用默认分配器, 不依赖任何 arena 的生命周期
+        class Value {
+        public:
+            using Array = std::vector<Ptr>;
+            class Object {
+                friend class Value;
+            public:
+                // 键在各个版本之间共享, 复制成员时不复制键的内容
+                using Key = std::shared_ptr<const std::string>;
+                using Member = std::pair<Key, Ptr>;
+            protected:
+                std::vector<Member> members;
+                std::vector<uint32_t> sorted;  // 成员较多时按键排序的下标, 用于二分查找
+
+                static constexpr size_t linear_limit = 8;
+
+                void build_index() {
+                    sorted.clear();
+                    if (members.size() <= linear_limit) {
+                        return;
+                    }
+                    sorted.resize(members.size());
+                    for (uint32_t i = 0; i < sorted.size(); ++i) {
+                        sorted[i] = i;
+                    }
+                    std::sort(sorted.begin(), sorted.end(), [this](uint32_t lhs, uint32_t rhs) {
+                        return *members[lhs].first < *members[rhs].first;
+                    });
+                }
+                // sorted 中第一个键不小于 key 的位置
+                [[nodiscard]] auto lower_bound(std::string_view key) const -> std::vector<uint32_t>::const_iterator {
+                    return std::lower_bound(sorted.begin(), sorted.end(), key,
+                                            [this](uint32_t lhs, std::string_view rhs) { return std::string_view{*members[lhs].first} < rhs; });
+                }
+
+                // 以下生成修改了一个成员的副本, 供 with/without 使用
+                [[nodiscard]] auto with_value(size_t index, Ptr value) const -> Object {
+                    auto copy = *this;
+                    copy.members[index].second = std::move(value);
+                    return copy;
+                }
+                // key 必须不存在; 新成员追加在末尾, 它的下标插入到索引中的对应位置
+                [[nodiscard]] auto with_member(std::string_view key, Ptr value) const -> Object {
+                    Object copy;
+                    copy.members.reserve(members.size() + 1);
+                    copy.members.assign(members.begin(), members.end());
+                    copy.members.emplace_back(std::make_shared<const std::string>(key), std::move(value));
+                    if (!sorted.empty()) {
+                        copy.sorted.reserve(sorted.size() + 1);
+                        copy.sorted.assign(sorted.begin(), sorted.end());
+                        copy.sorted.insert(copy.lower_bound(key), static_cast<uint32_t>(members.size()));
+                    } else {
+                        copy.build_index();
+                    }
+                    return copy;
+                }
+                // 删除第 index 个成员; 索引中去掉它, 之后的下标减一, 相对顺序不变
+                [[nodiscard]] auto without_member(size_t index) const -> Object {
+                    Object copy;
+                    copy.members.reserve(members.size() - 1);
+                    copy.members.insert(copy.members.end(), members.begin(), members.begin() + static_cast<std::ptrdiff_t>(index));
+                    copy.members.insert(copy.members.end(), members.begin() + static_cast<std::ptrdiff_t>(index) + 1, members.end());
+                    if (copy.members.size() > linear_limit) {
+                        copy.sorted.reserve(sorted.size() - 1);
+                        for (const auto position : sorted) {
+                            if (position != index) {
+                                copy.sorted.push_back(position > index ? position - 1 : position);
+                            }
+                        }
+                    }
+                    return copy;
+                }
+            public:
+                Object() = default;
+                explicit Object(std::vector<Member> members) : members(std::move(members)) {
+                    build_index();
+                }
+
+                // 成员的下标, 不存在时返回 size()
+                [[nodiscard]] auto index_of(std::string_view key) const -> size_t {
+                    if (sorted.empty()) {
+                        const auto it = std::find_if(members.begin(), members.end(), [&](const auto& member) { return *member.first == key; });
+                        return static_cast<size_t>(it - members.begin());
+                    }
+                    const auto it = lower_bound(key);
+                    return it != sorted.end() && *members[*it].first == key ? *it : members.size();
+                }
+                [[nodiscard]] auto find(std::string_view key) const -> Ptr {
+                    const auto index = index_of(key);
+                    return index == members.size() ? nullptr : members[index].second;
+                }
+                [[nodiscard]] auto size() const -> size_t { return members.size(); }
+                [[nodiscard]] auto begin() const { return members.begin(); }
+                [[nodiscard]] auto end() const { return members.end(); }
+            };
+            using Storage = std::variant<MonoNode, BoolNode, IntNode, FloatNode, std::string, Array, Object>;
+        protected:
+            Storage storage;
+
+            // 由 SAX 事件构造共享树, 未结束的容器放在显式栈上
+            class Builder {
+            protected:
+                struct Open {
+                    bool is_object;
+                    Array elements;
+                    std::vector<Object::Member> members;
+                    Object::Key key;  // 对象中等待值的键
+                };
+                std::vector<Open> stack;
+                Ptr root;
+
+                auto add(Ptr value) -> bool {
+                    if (stack.empty()) {
+                        root = std::move(value);
+                    } else if (auto& top = stack.back(); top.is_object) {
+                        top.members.emplace_back(std::move(top.key), std::move(value));
+                    } else {
+                        top.elements.push_back(std::move(value));
+                    }
+                    return true;
+                }
+            public:
+                auto on_null() -> bool { return add(make<MonoNode>()); }
+                auto on_bool(BoolNode value) -> bool { return add(make<BoolNode>(value)); }
+                auto on_int(IntNode value) -> bool { return add(make<IntNode>(value)); }
+                auto on_double(FloatNode value) -> bool { return add(make<FloatNode>(value)); }
+                auto on_string(std::string_view value) -> bool { return add(make<std::string>(value)); }
+                auto key(std::string_view name) -> bool {
+                    stack.back().key = std::make_shared<const std::string>(name);
+                    return true;
+                }
+                auto start_object() -> bool {
+                    stack.push_back({true, {}, {}, {}});
+                    return true;
+                }
+                auto end_object() -> bool {
+                    auto members = std::move(stack.back().members);
+                    stack.pop_back();
+                    return add(make<Object>(std::move(members)));
+                }
+                auto start_array() -> bool {
+                    stack.push_back({false, {}, {}, {}});
+                    return true;
+                }
+                auto end_array() -> bool {
+                    auto elements = std::move(stack.back().elements);
+                    stack.pop_back();
+                    return add(make<Array>(std::move(elements)));
+                }
+                auto take() -> Ptr { return std::move(root); }
+            };
+
+            // 沿 path 找到最后一步所在的容器, 用 leaf 生成替换后的容器, 再自底向上复制路径上的每个容器
+            // leaf 接收容器、下标(对象中不存在时为 size())与键, 返回新的容器, 失败时返回 nullptr
+            template<typename Leaf>
+            static auto rebuild(const Ptr& root, const Path& path, Leaf& leaf) -> Ptr;
+        public:
+            Value() = default;
+            explicit Value(Storage storage) : storage(std::move(storage)) {}
+
+            template<typename T, typename... Args>
+            static auto make(Args&&... args) -> Ptr {
+                return std::make_shared<const Value>(Storage{std::in_place_type<T>, std::forward<Args>(args)...});
+            }
+            // 复制一棵可变的树
+            static auto from_node(const Node& node) -> Ptr;
+
+            template<typename T>
+            [[nodiscard]] auto is() const -> bool { return std::holds_alternative<T>(storage); }
+            template<typename T>
+            [[nodiscard]] auto get_if() const -> const T* { return std::get_if<T>(&storage); }
+            [[nodiscard]] auto value() const -> const Storage& { return storage; }
+
+            // 数组的元素个数或对象的成员个数
+            [[nodiscard]] auto size() const -> size_t {
+                if (auto array = get_if<Array>()) return array->size();
+                if (auto object = get_if<Object>()) return object->size();
+                return 0;
+            }
+            // 不存在时返回 nullptr
+            [[nodiscard]] auto find(std::string_view key) const -> Ptr {
+                auto object = get_if<Object>();
+                return object ? object->find(key) : nullptr;
+            }
+            [[nodiscard]] auto at(size_t index) const -> Ptr {
+                auto array = get_if<Array>();
+                return array && index < array->size() ? (*array)[index] : nullptr;
+            }
+            [[nodiscard]] auto operator[](std::string_view key) const -> Ptr { return find(key); }
+
+            // 按 JSON Pointer 取值, 不含通配符; 不存在时返回 nullptr
+            static auto lookup(const Ptr& root, const Path& path) -> Ptr {
+                auto node = root;
+                for (size_t depth = 0; node && depth < path.size(); ++depth) {
+                    const auto index = path.index(depth);
+                    node = node->is<Array>() ? (index ? node->at(*index) : nullptr) : node->find(path.key(depth));
+                }
+                return node;
+            }
+
+            // 把 path 处的值设为 value, 返回共享其余子树的新根, 原来的根不变
+            // 对象中不存在的成员会被添加, 数组下标等于长度或为 `-` 时追加; 路径中间不存在、含通配符时返回 nullptr
+            static auto with(const Ptr& root, const Path& path, Ptr value) -> Ptr;
+            static auto with(const Ptr& root, std::string_view pointer, Ptr value) -> Ptr {
+                const auto path = Path::compile(pointer);
+                return path ? with(root, *path, std::move(value)) : nullptr;
+            }
+            static auto with(const Ptr& root, std::string_view pointer, const Node& value) -> Ptr {
+                return with(root, pointer, from_node(value));
+            }
+            // 删除 path 处的成员或数组元素, 不存在时返回 nullptr
+            static auto without(const Ptr& root, const Path& path) -> Ptr;
+            static auto without(const Ptr& root, std::string_view pointer) -> Ptr {
+                const auto path = Path::compile(pointer);
+                return path ? without(root, *path) : nullptr;
+            }
+
+            [[nodiscard]] auto to_node(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const -> Node;
+
+            // 按文档顺序把整棵树作为 SAX 事件交给 handler, 用显式栈代替递归; handler 返回 false 时停止并返回 false
+            template<JsonParser::SaxHandler Handler>
+            auto replay(Handler& handler) const -> bool {
+                struct Frame {
+                    const Array* array;
+                    const Object* object;
+                    size_t next;
+                };
+                std::vector<Frame> stack;
+                const auto value = [&](const Value& node) -> bool {
+                    return std::visit(
+                        [&]<typename T0>(const T0& arg) -> bool {
+                            using T = std::decay_t<T0>;
+                            if constexpr (std::is_same_v<T, MonoNode>) {
+                                return handler.on_null();
+                            } else if constexpr (std::is_same_v<T, BoolNode>) {
+                                return handler.on_bool(arg);
+                            } else if constexpr (std::is_same_v<T, IntNode>) {
+                                return handler.on_int(arg);
+                            } else if constexpr (std::is_same_v<T, FloatNode>) {
+                                return handler.on_double(arg);
+                            } else if constexpr (std::is_same_v<T, std::string>) {
+                                return handler.on_string(arg);
+                            } else if constexpr (std::is_same_v<T, Array>) {
+                                stack.push_back({&arg, nullptr, 0});
+                                return handler.start_array();
+                            } else {
+                                stack.push_back({nullptr, &arg, 0});
+                                return handler.start_object();
+                            }
+                        },
+                        node.storage);
+                };
+                if (!value(*this)) {
+                    return false;
+                }
+                while (!stack.empty()) {
+                    auto& frame = stack.back();
+                    const auto size = frame.array ? frame.array->size() : frame.object->size();
+                    if (frame.next == size) {
+                        const bool is_array = frame.array != nullptr;
+                        stack.pop_back();
+                        if (!(is_array ? handler.end_array() : handler.end_object())) {
+                            return false;
+                        }
+                        continue;
+                    }
+                    const auto index = frame.next++;
+                    if (frame.array) {
+                        if (!value(*(*frame.array)[index])) return false;  // 可能使 frame 失效
+                    } else {
+                        const auto& [name, element] = frame.object->members[index];
+                        if (!handler.key(*name) || !value(*element)) return false;
+                    }
+                }
+                return true;
+            }
+
+            template<JsonSerializer::OutputSink Sink>
+            void write(Sink& sink) const {
+                JsonSerializer::SaxWriter writer{sink};
+                replay(writer);
+            }
+            [[nodiscard]] auto to_str() const -> std::string {
+                std::string json_str;
+                JsonSerializer::StringSink sink{json_str};
+                write(sink);
+                return json_str;
+            }
+        };
+
+        inline auto Value::from_node(const Node& node) -> Ptr {
+            Builder builder;
+            JsonParser::replay(node, builder);
+            return builder.take();
+        }
+
+        inline auto Value::to_node(std::pmr::memory_resource* resource) const -> Node {
+            JsonParser::DomBuilder builder{resource};
+            replay(builder);
+            return builder.take();
+        }
+
+        template<typename Leaf>
+        auto Value::rebuild(const Ptr& root, const Path& path, Leaf& leaf) -> Ptr {
+            // 自上而下记下每一步的容器与下标, 路径多长都不会递归
+            std::vector<std::pair<const Value*, size_t>> steps;
+            steps.reserve(path.size());
+            const Value* node = root.get();
+            for (size_t depth = 0; depth < path.size(); ++depth) {
+                if (node == nullptr) {
+                    return nullptr;
+                }
+                const bool last = depth + 1 == path.size();
+                const auto& key = path.key(depth);
+                if (auto array = node->get_if<Array>()) {
+                    const auto index = key == "-" ? std::optional<size_t>{array->size()} : path.index(depth);
+                    if (!index || *index > array->size() || (!last && *index == array->size())) {
+                        return nullptr;
+                    }
+                    steps.emplace_back(node, *index);
+                    node = last ? nullptr : (*array)[*index].get();
+                } else if (auto object = node->get_if<Object>()) {
+                    const auto index = object->index_of(key);
+                    if (!last && index == object->size()) {
+                        return nullptr;
+                    }
+                    steps.emplace_back(node, index);
+                    node = last ? nullptr : object->members[index].second.get();
+                } else {
+                    return nullptr;
+                }
+            }
+            const auto [parent, index] = steps.back();
+            auto child = parent->is<Array>() ? leaf(*parent->get_if<Array>(), index)
+                                             : leaf(*parent->get_if<Object>(), index, path.key(path.size() - 1));
+            for (auto step = steps.size() - 1; child && step-- > 0;) {
+                const auto [container, position] = steps[step];
+                if (auto array = container->get_if<Array>()) {
+                    Array copy = *array;
+                    copy[position] = std::move(child);
+                    child = make<Array>(std::move(copy));
+                } else {
+                    child = make<Object>(container->get_if<Object>()->with_value(position, std::move(child)));
+                }
+            }
+            return child;
+        }
+
+        inline auto Value::with(const Ptr& root, const Path& path, Ptr value) -> Ptr {
+            if (!root || !value || !path.is_pointer()) {
+                return nullptr;
+            }
+            if (path.size() == 0) {
+                return value;
+            }
+            struct Leaf {
+                Ptr& value;
+                auto operator()(const Array& array, size_t index) const -> Ptr {
+                    Array copy;
+                    copy.reserve(array.size() + (index == array.size()));
+                    copy.assign(array.begin(), array.end());
+                    if (index == copy.size()) {
+                        copy.push_back(std::move(value));
+                    } else {
+                        copy[index] = std::move(value);
+                    }
+                    return make<Array>(std::move(copy));
+                }
+                auto operator()(const Object& object, size_t index, const std::string& key) const -> Ptr {
+                    return make<Object>(index == object.size() ? object.with_member(key, std::move(value))
+                                                               : object.with_value(index, std::move(value)));
+                }
+            } leaf{value};
+            return rebuild(root, path, leaf);
+        }
+
+        inline auto Value::without(const Ptr& root, const Path& path) -> Ptr {
+            if (!root || !path.is_pointer() || path.size() == 0) {
+                return nullptr;
+            }
+            struct Leaf {
+                auto operator()(const Array& array, size_t index) const -> Ptr {
+                    if (index == array.size()) return nullptr;
+                    Array copy;
+                    copy.reserve(array.size() - 1);
+                    copy.insert(copy.end(), array.begin(), array.begin() + static_cast<std::ptrdiff_t>(index));
+                    copy.insert(copy.end(), array.begin() + static_cast<std::ptrdiff_t>(index) + 1, array.end());
+                    return make<Array>(std::move(copy));
+                }
+                auto operator()(const Object& object, size_t index, const std::string&) const -> Ptr {
+                    if (index == object.size()) return nullptr;
+                    return make<Object>(object.without_member(index));
+                }
+            } leaf;
+            return rebuild(root, path, leaf);
+        }
+
+        // 多线程共享的文档: 读者用 load 取得根的快照, 之后遍历快照不需要任何同步, 快照在持有期间不会改变
+        // 写者生成新根后原子地替换, 并发写入时通过比较交换重试, 不会丢失更新
+        // load、store 与比较交换本身只保证原子, 不保证无锁: libstdc++ 的 atomic<shared_ptr> 与旧的 atomic_load
+        // 等函数都用按地址分片的锁保护引用计数, 临界区只有几条指令; 可以用 is_lock_free 查询
+        class Document {
+        protected:
+#if defined(__cpp_lib_atomic_shared_ptr)
+            std::atomic<Ptr> root;
+
+            [[nodiscard]] auto exchange_if(Ptr& expected, Ptr desired) -> bool {
+                return root.compare_exchange_weak(expected, std::move(desired));
+            }
+        public:
+            [[nodiscard]] auto load() const -> Ptr { return root.load(); }
+            void store(Ptr value) { root.store(std::move(value)); }
+            [[nodiscard]] auto is_lock_free() const -> bool { return root.is_lock_free(); }
+#else
+            Ptr root;
+
+            [[nodiscard]] auto exchange_if(Ptr& expected, Ptr desired) -> bool {
+                return std::atomic_compare_exchange_weak(&root, &expected, std::move(desired));
+            }
+        public:
+            [[nodiscard]] auto load() const -> Ptr { return std::atomic_load(&root); }
+            void store(Ptr value) { std::atomic_store(&root, std::move(value)); }
+            [[nodiscard]] auto is_lock_free() const -> bool { return std::atomic_is_lock_free(&root); }
+#endif
+            explicit Document(Ptr value = Value::make<MonoNode>()) : root(std::move(value)) {}
+            explicit Document(const Node& node) : Document(Value::from_node(node)) {}
+
+            // 用 update(旧根) 的结果替换根, update 返回 nullptr 时放弃并返回 false
+            // 与其他写者冲突时会以新的根重新调用 update
+            template<typename Update>
+            auto update(Update&& update) -> bool {
+                auto current = load();
+                while (true) {
+                    auto next = update(current);
+                    if (!next) {
+                        return false;
+                    }
+                    if (exchange_if(current, std::move(next))) {
+                        return true;
+                    }
+                }
+            }
+            auto with(const Path& path, const Ptr& value) -> bool {
+                return update([&](const Ptr& current) { return Value::with(current, path, value); });
+            }
+            auto with(std::string_view pointer, const Node& value) -> bool {
+                const auto path = Path::compile(pointer);
+                return path && with(*path, Value::from_node(value));
+            }
+            auto without(std::string_view pointer) -> bool {
+                const auto path = Path::compile(pointer);
+                return path && update([&](const Ptr& current) { return Value::without(current, *path); });
+            }
+        };
+    }
+
+    namespace JsonAsync {
+        using JsonNode::Node;
+
+        // sync_wait 等待任务结束的信号; 在持有锁时通知, 等待者醒来并销毁它时通知方已经不再访问它
+        struct Completion {
+            std::mutex mutex;
+            std::condition_variable ready;
+            bool done = false;
+
+            void signal() {
+                const std::lock_guard lock{mutex};
+                done = true;
+                ready.notify_all();
+            }
+            void wait() {
+                std::unique_lock lock{mutex};
+                ready.wait(lock, [this] { return done; });
+            }
+        };
+
+        // 惰性启动的协程任务: 被 co_await 时才开始执行, 结束后对称转移回等待者, 不占用额外线程
+        template<typename T>
+        class Task {
+        public:
+            struct promise_type {
+                std::coroutine_handle<> continuation = std::noop_coroutine();
+                std::variant<std::monostate, T, std::exception_ptr> result;
+                Completion* finished = nullptr;  // sync_wait 在这里等待
+
+                auto get_return_object() -> Task {
+                    return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+                }
+                auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+                struct FinalAwaiter {
+                    auto await_ready() noexcept -> bool { return false; }
+                    auto await_suspend(std::coroutine_handle<promise_type> handle) noexcept -> std::coroutine_handle<> {
+                        // 通知之后协程帧随时可能被销毁, 先取出需要的内容
+                        const auto continuation = handle.promise().continuation;
+                        if (auto finished = handle.promise().finished) {
+                            finished->signal();
+                        }
+                        return continuation;
+                    }
+                    void await_resume() noexcept {}
+                };
+                auto final_suspend() noexcept -> FinalAwaiter { return {}; }
+                template<std::convertible_to<T> U>
+                void return_value(U&& value) {
+                    result.template emplace<1>(std::forward<U>(value));
+                }
+                void unhandled_exception() {
+                    result.template emplace<2>(std::current_exception());
+                }
+            };
+        protected:
+            std::coroutine_handle<promise_type> handle;
+
+            explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+            auto take_result() -> T {
+                auto& result = handle.promise().result;
+                if (auto error = std::get_if<2>(&result)) {
+                    std::rethrow_exception(*error);
+                }
+                return std::move(std::get<1>(result));
+            }
+
+            template<typename U>
+            friend auto sync_wait(Task<U> task) -> U;
+        public:
+            Task(const Task&) = delete;
+            auto operator=(const Task&) -> Task& = delete;
+            Task(Task&& rhs) noexcept : handle(std::exchange(rhs.handle, nullptr)) {}
+            auto operator=(Task&& rhs) noexcept -> Task& {
+                if (this != &rhs) {
+                    if (handle) handle.destroy();
+                    handle = std::exchange(rhs.handle, nullptr);
+                }
+                return *this;
+            }
+            ~Task() {
+                if (handle) handle.destroy();
+            }
+
+            auto operator co_await() && {
+                struct Awaiter {
+                    Task& task;
+                    auto await_ready() const noexcept -> bool { return false; }
+                    auto await_suspend(std::coroutine_handle<> continuation) noexcept -> std::coroutine_handle<> {
+                        task.handle.promise().continuation = continuation;
+                        return task.handle;
+                    }
+                    auto await_resume() -> T { return task.take_result(); }
+                };
+                return Awaiter{*this};
+            }
+        };
+
+        // 在当前线程启动任务并阻塞到它结束; 任务可以在其他线程上被恢复
+        // 只用于程序入口与测试, 协程内部应直接 co_await
+        template<typename T>
+        auto sync_wait(Task<T> task) -> T {
+            Completion finished;
+            task.handle.promise().finished = &finished;
+            task.handle.resume();
+            finished.wait();
+            return task.take_result();
+        }
+
+        // 异步字节源: co_await source.read(buffer) 得到读入的字节数, 0 表示输入结束
+        template<typename Source>
+        concept AsyncSource = requires(Source& source, std::span<char> buffer) {
+            source.read(buffer);
+        };
+        // 异步输出: co_await sink.write(chunk) 得到 bool, false 表示写入失败(如连接已关闭)
+        // chunk 只在 co_await 返回之前有效
+        template<typename Sink>
+        concept AsyncSink = requires(Sink& sink, std::string_view chunk) {
+            sink.write(chunk);
+        };
+
+        struct Options {
+            size_t chunk_size = 64 * 1024;  // 每次读取或写出的字节数
+            size_t max_depth = JsonParser::default_max_depth;
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+            JsonSerializer::Options format{};
+        };
+
+        // 逐块读取并交给增量解析器, 等待输入时挂起而不是阻塞线程; handler 收到 SAX 事件
+        template<AsyncSource Source, JsonParser::SaxHandler Handler>
+        auto parse_sax(Source& source, Handler& handler, Options options = {}) -> Task<bool> {
+            JsonStream::BasicIncrementalParser<Handler> parser{handler, options.max_depth};
+            std::vector<char> buffer(std::max<size_t>(options.chunk_size, 1));
+            while (true) {
+                const size_t count = co_await source.read(std::span<char>{buffer});
+                if (count == 0) {
+                    co_return parser.finish();
+                }
+                if (!parser.feed({buffer.data(), count})) {
+                    co_return false;
+                }
+            }
+        }
+
+        // 同上, 构造 Node 树; 输入不完整或语法错误时返回空
+        template<AsyncSource Source>
+        auto parse(Source& source, Options options = {}) -> Task<std::optional<Node>> {
+            JsonStream::IncrementalParser parser{options.resource, options.max_depth};
+            std::vector<char> buffer(std::max<size_t>(options.chunk_size, 1));
+            while (true) {
+                const size_t count = co_await source.read(std::span<char>{buffer});
+                if (count == 0) {
+                    co_return parser.finish();
+                }
+                if (!parser.feed({buffer.data(), count})) {
+                    co_return std::optional<Node>{};
+                }
+            }
+        }
+
+        // 边序列化边写出, 每生成约 chunk_size 字节等待一次 sink, 内存中最多只有一块输出
+        // node 在任务结束前必须保持不变; sink 写入失败时返回 false
+        template<AsyncSink Sink>
+        auto write(Sink& sink, const Node& node, Options options = {}) -> Task<bool> {
+            JsonSerializer::ChunkedWriter writer{node, options.format};
+            const auto budget = std::max<size_t>(options.chunk_size, 1);
+            std::string chunk;
+            chunk.reserve(budget + budget / 8);
+            while (true) {
+                const bool done = writer.pump(chunk, budget);
+                if (!chunk.empty()) {
+                    const bool ok = co_await sink.write(std::string_view{chunk});
+                    if (!ok) {
+                        co_return false;
+                    }
+                    chunk.clear();
+                }
+                if (done) {
+                    co_return true;
+                }
+            }
+        }
+    }
+
+    namespace JsonBind {
+        using JsonNode::Node;
+
+        // 结构体的一个成员: json 中的键名与成员指针
+        template<typename Class, typename Member>
+        struct Field {
+            std::string_view name;
+            Member Class::* member;
+        };
+
+        template<typename Class, typename Member>
+        constexpr auto field(std::string_view name, Member Class::* member) -> Field<Class, Member> {
+            return {name, member};
+        }
+
+        // 由 JSON_BIND 特化, 提供 `static constexpr auto fields`: 由 Field 组成的 tuple
+        template<typename T>
+        struct Binding;
+
+        template<typename T>
+        concept Bound = requires { Binding<T>::fields; };
+
+        template<typename T>
+        inline constexpr bool is_optional = false;
+        template<typename T>
+        inline constexpr bool is_optional<std::optional<T>> = true;
+
+        template<typename T>
+        inline constexpr bool is_vector = false;
+        template<typename T, typename Allocator>
+        inline constexpr bool is_vector<std::vector<T, Allocator>> = true;
+
+        // 编译期为 T 的键名构造完美哈希表, 运行时一次哈希加一次比较定位成员
+        // 哈希只取长度与首、中、尾三个字节; 找不到无冲突的种子时退回按长度过滤的线性比较
+        template<Bound T>
+        class KeyIndex {
+        public:
+            static constexpr size_t count = std::tuple_size_v<std::decay_t<decltype(Binding<T>::fields)>>;
+        protected:
+            static constexpr auto names = std::apply(
+                [](const auto&... fields) { return std::array<std::string_view, sizeof...(fields)>{fields.name...}; },
+                Binding<T>::fields);
+
+            struct Plan {
+                uint32_t seed = 0;
+                uint32_t mask = 0;
+                bool found = false;
+            };
+
+            static constexpr auto hash(std::string_view key, uint32_t seed) -> uint32_t {
+                auto h = seed ^ (static_cast<uint32_t>(key.size()) * 0x9E3779B1u);
+                if (!key.empty()) {
+                    h = (h ^ static_cast<uint8_t>(key.front())) * 0x01000193u;
+                    h = (h ^ static_cast<uint8_t>(key[key.size() / 2])) * 0x01000193u;
+                    h = (h ^ static_cast<uint8_t>(key.back())) * 0x01000193u;
+                }
+                return h ^ (h >> 15);
+            }
+
+            static constexpr auto make_plan() -> Plan {
+                for (size_t size = std::bit_ceil(std::max<size_t>(count * 2, 1)); size <= count * 16 + 16; size *= 2) {
+                    for (uint32_t seed = 1; seed <= 2048; ++seed) {
+                        std::array<bool, 1024> used{};
+                        if (size > used.size()) {
+                            return {};
+                        }
+                        bool collided = false;
+                        for (const auto name : names) {
+                            auto& slot = used[hash(name, seed) & (size - 1)];
+                            collided = collided || slot;
+                            slot = true;
+                        }
+                        if (!collided) {
+                            return {seed, static_cast<uint32_t>(size - 1), true};
+                        }
+                    }
+                }
+                return {};
+            }
+
+            static constexpr Plan plan = make_plan();
+
+            // 槽位保存成员序号加一, 0 表示空槽
+            static constexpr auto table = [] {
+                std::array<uint16_t, plan.mask + 1> slots{};
+                if (plan.found) {
+                    for (size_t i = 0; i < count; ++i) {
+                        slots[hash(names[i], plan.seed) & plan.mask] = static_cast<uint16_t>(i + 1);
+                    }
+                }
+                return slots;
+            }();
+        public:
+            // 返回成员序号, 未知的键返回 count
+            static auto find(std::string_view key) -> size_t {
+                if constexpr (plan.found) {
+                    const auto slot = table[hash(key, plan.seed) & plan.mask];
+                    return slot != 0 && names[slot - 1] == key ? slot - 1 : count;
+                } else {
+                    for (size_t i = 0; i < count; ++i) {
+                        if (names[i].size() == key.size() && names[i] == key) {
+                            return i;
+                        }
+                    }
+                    return count;
+                }
+            }
+        };
+
+        // 直接在输入上扫描并写入目标对象, 不构造 Node; 未知的键被跳过, 缺失的成员保持原值
+        // 递归绑定的类型按输入嵌套递归, 所以与 SaxParser 一样限制深度; 出错之后 Reader 不能继续使用
+        class Reader {
+        protected:
+            const char* cursor;
+            const char* last;
+            std::string scratch;  // 含转义的键解码到这里
+            size_t max_depth;
+            size_t depth = 0;     // 正在读取的数组与对象的层数
+
+            // 进入一层容器, 超过 max_depth 时失败
+            auto enter() -> bool {
+                if (depth >= max_depth) {
+                    return false;
+                }
+                ++depth;
+                return true;
+            }
+
+            auto skip_whitespace() -> const char* {
+                return cursor = JsonScan::skip_whitespace(cursor, last);
+            }
+            auto consume(char ch) -> bool {
+                if (skip_whitespace() == last || *cursor != ch) {
+                    return false;
+                }
+                ++cursor;
+                return true;
+            }
+            // 读取的值结尾在 end, 文法错误时 end 为 nullptr
+            auto advance(const char* end) -> bool {
+                if (end == nullptr) {
+                    return false;
+                }
+                cursor = end;
+                return true;
+            }
+            // 读取引号中的原始内容
+            auto read_string(std::string_view& raw, bool& escaped) -> bool {
+                if (!consume('"')) {
+                    return false;
+                }
+                const auto close = JsonScan::scan_string(cursor, last, escaped);
+                if (close == nullptr) {
+                    return false;
+                }
+                raw = std::string_view{cursor, static_cast<size_t>(close - cursor)};
+                cursor = close + 1;
+                return true;
+            }
+            template<typename T>
+            auto read_number(T& value) -> bool {
+                bool is_float = false;
+                const auto end = JsonScan::skip_number(cursor, last, is_float);
+                if (end == nullptr || (std::is_integral_v<T> && is_float)) {
+                    return false;
+                }
+                const auto [ptr, error] = std::from_chars(cursor, end, value);
+                return error == std::errc{} && advance(ptr);
+            }
+            // 逐个解析 `[ ... ]` 中的元素, element 负责读取一个元素
+            template<typename Element>
+            auto read_array(Element&& element) -> bool {
+                if (!consume('[') || !enter()) {
+                    return false;
+                }
+                if (skip_whitespace() != last && *cursor == ']') {
+                    ++cursor;
+                    --depth;
+                    return true;
+                }
+                do {
+                    if (!element()) {
+                        return false;
+                    }
+                } while (consume(','));
+                --depth;
+                return consume(']');
+            }
+            template<Bound T>
+            auto read_object(T& object) -> bool {
+                if (!consume('{') || !enter()) {
+                    return false;
+                }
+                if (skip_whitespace() != last && *cursor == '}') {
+                    ++cursor;
+                    --depth;
+                    return true;
+                }
+                do {
+                    std::string_view raw;
+                    bool escaped = false;
+                    if (!read_string(raw, escaped) || !consume(':')) {
+                        return false;
+                    }
+                    const auto key = JsonScan::decode_string(raw, escaped, scratch);
+                    if (!key || !read_member(object, KeyIndex<T>::find(*key),
+                                     std::make_index_sequence<KeyIndex<T>::count>{})) {
+                        return false;
+                    }
+                } while (consume(','));
+                --depth;
+                return consume('}');
+            }
+            // 按编译期生成的序号分派到对应成员, 未知的键跳过其值
+            template<Bound T, size_t... I>
+            auto read_member(T& object, size_t index, std::index_sequence<I...>) -> bool {
+                bool ok = true;
+                const bool matched = ((index == I && (ok = read(object.*(std::get<I>(Binding<T>::fields).member)), true)) || ...);
+                if (!matched) {
+                    skip_whitespace();
+                    return advance(JsonScan::skip_value(cursor, last));
+                }
+                return ok;
+            }
+        public:
+            explicit Reader(std::string_view json_str, size_t max_depth = JsonParser::default_max_depth)
+                : cursor(json_str.data()), last(json_str.data() + json_str.size()), max_depth(max_depth) {}
+
+            template<typename T>
+            auto read(T& value) -> bool {
+                if (skip_whitespace() == last) {
+                    return false;
+                }
+                if constexpr (Bound<T>) {
+                    return read_object(value);
+                } else if constexpr (std::is_same_v<T, bool>) {
+                    value = *cursor == 't';
+                    return advance(JsonScan::skip_literal(cursor, last, value ? "true" : "false"));
+                } else if constexpr (std::is_arithmetic_v<T>) {
+                    return read_number(value);
+                } else if constexpr (std::is_same_v<T, std::string>) {
+                    std::string_view raw;
+                    bool escaped = false;
+                    if (!read_string(raw, escaped)) {
+                        return false;
+                    }
+                    if (!escaped) {
+                        value.assign(raw);
+                        return true;
+                    }
+                    value.clear();
+                    return JsonScan::unescape(raw, value);
+                } else if constexpr (is_optional<T>) {
+                    if (*cursor == 'n') {
+                        value.reset();
+                        return advance(JsonScan::skip_literal(cursor, last, "null"));
+                    }
+                    return read(value.emplace());
+                } else if constexpr (is_vector<T>) {
+                    value.clear();
+                    return read_array([&] { return read(value.emplace_back()); });
+                } else if constexpr (std::is_same_v<T, Node>) {
+                    // 结构不固定的部分仍然构造成 Node; 与其余部分一样按严格的文法读取
+                    const auto end = JsonScan::skip_value(cursor, last);
+                    if (end == nullptr) {
+                        return false;
+                    }
+                    JsonParser::Parser parser{std::string_view{cursor, static_cast<size_t>(end - cursor)}};
+                    parser.set_max_depth(max_depth - depth);
+                    parser.set_strict(true);
+                    auto node = parser.parse();
+                    if (!node) {
+                        return false;
+                    }
+                    value = std::move(*node);
+                    return advance(end);
+                } else {
+                    static_assert(!sizeof(T), "type is not bindable, declare it with JSON_BIND");
+                }
+            }
+
+            // 值之后只允许出现空白
+            auto at_end() -> bool {
+                return skip_whitespace() == last;
+            }
+        };
+
+        // 把输入直接反序列化到已有对象中, 可以复用其中容器的容量
+        // 数组与对象的嵌套超过 max_depth 时失败, 与 Parser 的限制相同
+        template<typename T>
+        auto parse_into(std::string_view json_str, T& value, size_t max_depth = JsonParser::default_max_depth) -> bool {
+            Reader reader{json_str, max_depth};
+            return reader.read(value) && reader.at_end();
+        }
+
+        template<typename T>
+        auto parse_into(std::string_view json_str, size_t max_depth = JsonParser::default_max_depth) -> std::optional<T> {
+            T value{};
+            if (!parse_into(json_str, value, max_depth)) {
+                return {};
+            }
+            return value;
+        }
+
+        // 直接从对象序列化, 成员按声明顺序输出
+        template<typename T, JsonSerializer::OutputSink Sink>
+        void write(const T& value, Sink& sink) {
+            using JsonSerializer::Serializer;
+            if constexpr (Bound<T>) {
+                sink.put('{');
+                bool first = true;
+                std::apply(
+                    [&](const auto&... fields) {
+                        ((sink.write(first ? "\"" : ",\""), sink.write(fields.name), sink.write("\":"),
+                          write(value.*(fields.member), sink), first = false), ...);
+                    },
+                    Binding<T>::fields);
+                sink.put('}');
+            } else if constexpr (std::is_same_v<T, bool>) {
+                sink.write(value ? "true" : "false");
+            } else if constexpr (std::is_integral_v<T>) {
+                char buffer[24];
+                const auto end = std::to_chars(buffer, buffer + sizeof buffer, value).ptr;
+                sink.write({buffer, static_cast<size_t>(end - buffer)});
+            } else if constexpr (std::is_floating_point_v<T>) {
+                Serializer::write_float(sink, static_cast<double>(value));
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                Serializer::write_string(sink, value);
+            } else if constexpr (is_optional<T>) {
+                if (value) {
+                    write(*value, sink);
+                } else {
+                    sink.write("null");
+                }
+            } else if constexpr (is_vector<T>) {
+                sink.put('[');
+                bool first = true;
+                for (const auto& element : value) {
+                    if (!first) sink.put(',');
+                    first = false;
+                    write(element, sink);
+                }
+                sink.put(']');
+            } else if constexpr (std::is_same_v<T, Node>) {
+                Serializer::write(sink, value);
+            } else {
+                static_assert(!sizeof(T), "type is not bindable, declare it with JSON_BIND");
+            }
+        }
+
+        template<typename T>
+        auto generate(const T& value) -> std::string {
+            std::string json_str;
+            JsonSerializer::StringSink sink{json_str};
+            write(value, sink);
+            return json_str;
+        }
+    }
+
+    using JsonNode::Node;
+    using JsonNode::Key, JsonNode::KeyPool;
+    using JsonNode::ArrayNode, JsonNode::ObjectNode, JsonNode::Int64Array, JsonNode::DoubleArray;
+    using JsonNode::MonoNode, JsonNode::ValueType, JsonNode::BoolNode, JsonNode::IntNode, JsonNode::FloatNode, JsonNode::StringNode;
+    using JsonDocument::Document;
+    using JsonPath::Path;
+    using JsonValidate::validate;
+    using JsonBind::parse_into, JsonBind::write, JsonBind::generate;
+
+    inline auto JsonNode::Node::from_str(std::string_view json_str) -> std::optional<Node> {
+        auto parser = JsonParser::Parser{json_str};
+        return parser.parse();
+    }
+
+    inline auto JsonNode::Node::from_str(const char* data, size_t size) -> std::optional<Node> {
+        return from_str(std::string_view{data, size});
+    }
+
+    inline auto JsonNode::Node::from_file(const std::filesystem::path& path) -> std::optional<Node> {
+        const auto file = JsonIO::MappedFile::open(path);
+        if (!file) {
+            return {};
+        }
+        return from_str(file->view());
+    }
+
+    inline auto JsonNode::Node::to_str() const -> std::string {
+        return JsonSerializer::Serializer::generate(*this);
+    }
+
+    namespace JsonNode {
+        inline auto operator<<(std::ostream& out, const Node& rhs) -> std::ostream& {
+            JsonSerializer::StreamSink sink{out};
+            JsonSerializer::Serializer::write(sink, rhs);
+            return out;
+        }
+    }
+};
+
+// 声明结构体参与绑定的成员, 在全局命名空间中使用, 最多 16 个成员:
+//     struct Point { int x; int y; };
+//     JSON_BIND(Point, x, y);
+#define JSON_BIND(Type, ...)                                                              \
+    template<>                                                                            \
+    struct json::JsonBind::Binding<Type> {                                                \
+        static constexpr auto fields = std::make_tuple(JSON_BIND_FIELDS(Type, __VA_ARGS__)); \
+    }
+#define JSON_BIND_FIELD(Type, member) ::json::JsonBind::field(#member, &Type::member)
+#define JSON_BIND_1(T, a) JSON_BIND_FIELD(T, a)
+#define JSON_BIND_2(T, a, ...) JSON_BIND_FIELD(T, a), JSON_BIND_1(T, __VA_ARGS__)
+#define JSON_BIND_3(T, a, ...) JSON_BIND_FIELD(T, a), JSON_BIND_2(T, __VA_ARGS__)
+#define JSON_BIND_4(T, a, ...) JSON_BIND_FIELD(T, a), JSON_BIND_3(T, __VA_ARGS__)
+#define JSON_BIND_5(T, a, ...) JSON_BIND_FIELD(T, a), JSON_BIND_4(T, __VA_ARGS__)
+#define JSON_BIND_6(T, a, ...) JSON_BIND_FIELD(T, a), JSON_BIND_5(T, __VA_ARGS__)
+#define JSON_BIND_7(T, a, ...) JSON_BIND_FIELD(T, a), JSON_BIND_6(T, __VA_ARGS__)
+#define JSON_BIND_8(T, a, ...) JSON_BIND_FIELD(T, a), JSON_BIND_7(T, __VA_ARGS__)
+#define JSON_BIND_9(T, a, ...) JSON_BIND_FIELD(T, a), JSON_BIND_8(T, __VA_ARGS__)
+#define JSON_BIND_10(T, a, ...) JSON_BIND_FIELD(T, a), JSON_BIND_9(T, __VA_ARGS__)
+#define JSON_BIND_11(T, a, ...) JSON_BIND_FIELD(T, a), JSON_BIND_10(T, __VA_ARGS__)
+#define JSON_BIND_12(T, a, ...) JSON_BIND_FIELD(T, a), JSON_BIND_11(T, __VA_ARGS__)
+#define JSON_BIND_13(T, a, ...) JSON_BIND_FIELD(T, a), JSON_BIND_12(T, __VA_ARGS__)
+#define JSON_BIND_14(T, a, ...) JSON_BIND_FIELD(T, a), JSON_BIND_13(T, __VA_ARGS__)
+#define JSON_BIND_15(T, a, ...) JSON_BIND_FIELD(T, a), JSON_BIND_14(T, __VA_ARGS__)
+#define JSON_BIND_16(T, a, ...) JSON_BIND_FIELD(T, a), JSON_BIND_15(T, __VA_ARGS__)
+#define JSON_BIND_SELECT(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, NAME, ...) NAME
+#define JSON_BIND_FIELDS(T, ...)                                                                           \
+    JSON_BIND_SELECT(__VA_ARGS__, JSON_BIND_16, JSON_BIND_15, JSON_BIND_14, JSON_BIND_13, JSON_BIND_12,     \
+                     JSON_BIND_11, JSON_BIND_10, JSON_BIND_9, JSON_BIND_8, JSON_BIND_7, JSON_BIND_6,          \
+                     JSON_BIND_5, JSON_BIND_4, JSON_BIND_3, JSON_BIND_2, JSON_BIND_1)(T, __VA_ARGS__)